@@ -2,16 +2,131 @@
 
 #define FRAMING_ERROR 0x01
 #define PARITY_ERROR 0x02
+#define FRAME_OVERRUN_ERROR 0x04 // frame mode: a character of the frame was dropped
+#define CRC_ERROR 0x08           // frame mode with CRC: the frame CRC check failed
 
 #define FM0_PARITY_DISABLED 0
 #define FM0_PARITY_ENABLED  1
 
+/* RX option flags (_rx_options) */
+#define RX_OPTION_PACKED_FIFO 0x01
+#define RX_OPTION_DMA         0x02
+#define RX_OPTION_EDGE_DECODE 0x04
+#define RX_OPTION_AUTO_BAUD   0x08
+#define RX_OPTION_TIMESTAMP   0x10
+#define RX_OPTION_FRAME       0x20
+#define RX_OPTION_CRC         0x40
+#define RX_OPTION_OVERWRITE   0x80 // on overrun, drop the oldest word rather than the new one
+#define RX_OPTION_MULTIDROP   0x100 // word MSB is an address mark, keep only words addressed to this station
+
+/* TX option flags (_tx_options) */
+#define TX_OPTION_PACKED_FIFO 0x01
+#define TX_OPTION_DMA         0x02
+#define TX_OPTION_RUN_LENGTH  0x04
+#define TX_OPTION_FRAME       0x08
+#define TX_OPTION_CRC         0x10
+#define TX_OPTION_IDLE_PARK   0x20 // no TX check polling while the TX FIFO is empty
+#define TX_OPTION_TIMED       0x40 // TX_START_TIME entries honored
+
+/* TX word flags, in the MSB of a TX FIFO word (unpacked FIFO only) */
+#define TX_END_OF_FRAME       0x01
+#define TX_START_TIME         0x02 // timed entry (TX_OPTION_TIMED): the LSBs are the start time of the words that follow
+
+/* TX frame mode states (_tx_frame_state) */
+#define TX_FRAME_IN_FRAME     0
+#define TX_FRAME_LAST_WORD    1 // word ending the frame is being sent
+#define TX_FRAME_GAP          2 // frame ended at _tx_frame_end_time
+
 struct uart_rx_data_word_t
 {
     uint8_t _error_flags;
     uint24_t _data;
 };
 
+/* with RX_OPTION_TIMESTAMP, each data word is followed by its start bit time */
+struct uart_rx_time_word_t
+{
+    uint8_t _reserved;
+    uint24_t _start_time;
+};
+
+/* frame mode: RX frame queue entry */
+struct uart_rx_frame_word_t
+{
+    uint8_t _error_flags;     // OR of the character error flags, plus FRAME_OVERRUN_ERROR
+    uint24_t _start_offset;   // byte offset of the first character in the RX FIFO
+    uint8_t _reserved;
+    int24_t _length;          // number of characters
+};
+
+/* descriptor of a block of FIFO data handed to DMA; the host presets the 
+   address MSB byte so the first word reads as a complete system bus address */
+struct uart_dma_block_t
+{
+    uint8_t _sys_addr_msb;
+    uint24_t _sys_addr;
+    int24_t _byte_size; /* 0 when no block is pending */
+};
+
+/* descriptor of a TX FIFO block to be filled by DMA from the host buffer */
+struct uart_tx_dma_block_t
+{
+    uint8_t _dst_addr_msb;
+    uint24_t _dst_addr;
+    uint8_t _src_addr_msb;
+    uint24_t _src_addr;
+    int24_t _byte_size; /* cleared by the DMA once the block is filled */
+};
+
+/* frame mode and CRC mode state, allocated by the host with RX/TX frame or 
+   CRC mode only */
+struct uart_frame_block_t
+{
+    int24_t _frame_gap;           // minimum silence between frames (e.g. 3.5 character times)
+    struct uart_rx_frame_word_t* _rx_frame_queue_start_p;
+    struct uart_rx_frame_word_t* _rx_frame_queue_end_p;
+    struct uart_rx_frame_word_t* _rx_frame_queue_pop_p;
+    struct uart_rx_frame_word_t* _rx_frame_queue_push_p;
+    /* CRC-16, reflected (LSB first) polynomial, no final XOR */
+    uint24_t _crc_poly;           // e.g. 0xA001 for Modbus, 0x8408 for CCITT
+    uint24_t _crc_init;           // CRC value at the start of a frame
+    uint24_t _rx_crc;             // running CRC of the received characters
+    uint24_t _tx_crc;             // running CRC of the transmitted characters
+    /* eTPU private */
+    uint8_t _rx_frame_errors;     // error summary of the frame
+    int24_t _rx_frame_end_time;   // time the frame ends if the line stays idle
+    uint8_t _rx_frame_active;     // a frame is being received
+    int24_t _rx_frame_start_offset; // FIFO byte offset of the first character of the frame
+    uint8_t _tx_frame_state;      // TX_FRAME_* state
+    int24_t _rx_frame_length;     // characters received in the frame
+    int8_t _tx_crc_bytes_left;    // CRC bytes still to be appended to the frame
+    int24_t _tx_frame_end_time;   // start of the stop bit of the last word of the frame (its TX check time)
+};
+
+/* statistics, allocated and cleared by the host when enabled only, counts
+   wrap at 0xffffff */
+struct uart_stat_block_t
+{
+    uint24_t _rx_count;           // characters received
+    uint24_t _rx_overrun_count;   // characters dropped for lack of RX FIFO room
+    uint24_t _framing_error_count;
+    uint24_t _parity_error_count;
+    uint24_t _tx_count;           // characters transmitted
+    uint24_t _cts_stall_count;    // times TX was held by CTS with data waiting
+    int24_t _rx_fifo_high_water;  // most RX FIFO bytes used
+    int24_t _tx_fifo_high_water;  // most TX FIFO bytes used, as seen when popping
+    uint8_t _tx_cts_stalled;      // TX currently held by CTS
+};
+
+/* auto-baud state, allocated by the host with auto-baud only */
+struct uart_autobaud_block_t
+{
+    int8_t _edge_count;           // sync character falling edges seen, -1 once bit time measured
+    int24_t _start_time;          // first falling edge time
+    int24_t _last_time;           // previous falling edge time
+    int24_t _interval;            // first falling edge interval (2 bit times)
+};
+
 
 _eTPU_class UART
 {
@@ -19,11 +134,15 @@ _eTPU_class UART
 public:
     int8_t _bit_count;
     int24_t _bit_time;
+    uint8_t _bit_time_frac; // fractional part of bit time, in 1/256 counts
     int24_t _stop_time;
 
     uint8_t _parity_select; // 0=even, 1=odd, enabled when FM0=1, otherwise parity disabled if FM0=0
     
     uint8_t _overrun_error;
+
+    uint24_t _rx_options; // RX_OPTION_* flags
+    uint24_t _tx_options; // TX_OPTION_* flags
     
     /* FIFO control */
     int24_t _rx_buffer_byte_size;
@@ -31,6 +150,20 @@ public:
     struct uart_rx_data_word_t* _rx_buffer_end_p;
     struct uart_rx_data_word_t* _rx_buffer_pop_p;
     struct uart_rx_data_word_t* _rx_buffer_push_p;
+    struct uart_rx_data_word_t* _rx_drop_p; // overwrite-oldest: end of the words dropped by the eTPU (pop is host written)
+    uint8_t* _rx_error_map_p; // packed FIFO only, 2 error flag bits per character
+    
+    int24_t _rx_idle_timeout; // time from stop bit to idle line interrupt, 0 if disabled
+    int24_t _rx_coalesce_timeout; // coalescing: max time from the first word received to interrupt, 0 if disabled
+    int24_t _rx_coalesce_count;   // coalescing: words received to interrupt
+    
+    /* optional feature state, in blocks allocated only when enabled */
+    struct uart_frame_block_t* _frame_block_p;          // frame mode and CRC mode
+    struct uart_autobaud_block_t* _rx_autobaud_block_p; // auto-baud
+    struct uart_stat_block_t* _stat_block_p;            // statistics, 0 if not kept
+    
+    uint24_t _rx_station_address; // multidrop: address of this station, address mark bit clear
+    uint24_t _rx_station_mask;    // multidrop: address bits compared, address mark bit clear
     
     int24_t _rx_rts_halt_threshold;
     int24_t _rx_rts_resume_threshold;
@@ -44,6 +177,14 @@ public:
     int24_t _rx_fifo_int_threshold;
     int24_t _tx_fifo_int_threshold;
 
+    /* DMA support */
+    uint24_t _dma_sys_base; /* low 24 bits of the data RAM system bus address */
+    struct uart_dma_block_t* _rx_dma_block_p;
+    struct uart_tx_dma_block_t* _tx_dma_block_p;
+    int24_t _tx_dma_block_byte_size; // maximum TX block size
+    uint24_t _tx_dma_src_addr;       // low 24 bits of the next host buffer address
+    int24_t _tx_dma_remaining_size;  // host buffer bytes not yet requested or filled
+
     /* hardware flow control */
     int8_t _cts_chan_num;
     int8_t _rts_chan_num;
@@ -52,17 +193,31 @@ public:
     int8_t _tx_enable_chan_num;
     int24_t _tx_enable_post_delay;
     
+    uint8_t _tx_parked;          // idle park: TX check stopped on an empty TX FIFO, wake HSR needed
+    
 private:
     uint24_t _rx_shift_register;
     uint24_t _tx_shift_register;
     int8_t _rx_running_bit_count;
     int8_t _tx_running_bit_count;
     uint8_t _rx_parity_calc;
+    uint8_t _rx_frac_acc;        // bit time fractional part accumulator
     uint24_t _rx_one_bit;
     uint24_t _rx_data_mask;
+    int24_t _rx_edge_start_time; // edge decode: start bit edge time
+    int8_t _rx_edge_cell;        // edge decode: bit cell of last edge, start bit is cell 0
+    uint8_t _rx_edge_level;      // edge decode: line level since last edge
+    int24_t _rx_idle_time;              // idle timeout: time the line is idle since the last stop bit
+    int24_t _rx_start_time;             // timestamp: start bit falling edge time of the current word
+    uint8_t _rx_addressed;              // multidrop: the last address word received matched this station
+    int24_t _rx_coalesce_start_time;    // coalescing: stop bit time of the first word since the last interrupt
+    int24_t _rx_coalesce_pending;       // coalescing: words received since the last interrupt
     
     uint8_t _tx_parity_calc;
+    uint8_t _tx_frac_acc;        // bit time fractional part accumulator
+    uint8_t _tx_level;           // run-length mode: level of the current bit run
     _Bool _tx_enable_active;
+    int24_t _tx_dma_pending_size;
 
 
     /* threads */
@@ -79,19 +234,27 @@ private:
     /* RX threads */
     _eTPU_thread DetectWord(_eTPU_matches_enabled);
     _eTPU_thread DetectBit(_eTPU_matches_enabled);
+    _eTPU_thread DetectEdge(_eTPU_matches_enabled);
+    _eTPU_thread DetectEdgeStop(_eTPU_matches_enabled);
     _eTPU_thread UpdateRTS(_eTPU_matches_enabled);
 
     /* TX threads */
     _eTPU_thread TransmitCheck(_eTPU_matches_enabled);
     _eTPU_thread TransmitBit(_eTPU_matches_enabled);
+    _eTPU_thread Wake_TX_TCR1(_eTPU_matches_disabled);
+    _eTPU_thread Wake_TX_TCR2(_eTPU_matches_disabled);
     
     /* fragments */
     _eTPU_fragment Common_RX_Init_fragment();
     _eTPU_fragment Common_TX_Init_fragment();
+    _eTPU_fragment ReceiveStop_fragment();
+    _eTPU_fragment ArmIdle_fragment();
     _eTPU_fragment FinishTXE_fragment();
+    _eTPU_fragment Wake_TX_fragment();
     
     /* methods */
-    /* none */
+    void CloseFrame();
+    struct uart_rx_data_word_t* OldestRxWord(struct uart_rx_data_word_t* pop_p);
 
     /* entry table(s) */
     _eTPU_entry_table UART_RX;    
@@ -23,10 +23,22 @@
 
 #pragma export_autodef_macro "ETPU_UART_RX_FRAMING_ERROR", 0x01
 #pragma export_autodef_macro "ETPU_UART_RX_PARITY_ERROR", 0x02
+#pragma export_autodef_macro "ETPU_UART_RX_FRAME_OVERRUN_ERROR", FRAME_OVERRUN_ERROR
+#pragma export_autodef_macro "ETPU_UART_RX_CRC_ERROR", CRC_ERROR
 
 #pragma export_autodef_macro "ETPU_UART_FM0_PARITY_DISABLED", FM0_PARITY_DISABLED
 #pragma export_autodef_macro "ETPU_UART_FM0_PARITY_ENABLED", FM0_PARITY_ENABLED
 
+#pragma export_autodef_macro "ETPU_UART_RX_OPTION_PACKED_FIFO", RX_OPTION_PACKED_FIFO
+#pragma export_autodef_macro "ETPU_UART_RX_OPTION_DMA", RX_OPTION_DMA
+#pragma export_autodef_macro "ETPU_UART_RX_OPTION_EDGE_DECODE", RX_OPTION_EDGE_DECODE
+#pragma export_autodef_macro "ETPU_UART_RX_OPTION_AUTO_BAUD", RX_OPTION_AUTO_BAUD
+#pragma export_autodef_macro "ETPU_UART_RX_OPTION_TIMESTAMP", RX_OPTION_TIMESTAMP
+#pragma export_autodef_macro "ETPU_UART_RX_OPTION_FRAME", RX_OPTION_FRAME
+#pragma export_autodef_macro "ETPU_UART_RX_OPTION_CRC", RX_OPTION_CRC
+#pragma export_autodef_macro "ETPU_UART_RX_OPTION_OVERWRITE", RX_OPTION_OVERWRITE
+#pragma export_autodef_macro "ETPU_UART_RX_OPTION_MULTIDROP", RX_OPTION_MULTIDROP
+
 
 _eTPU_thread UART::Init_RX_TCR1(_eTPU_matches_disabled)
 {
@@ -39,7 +51,7 @@ _eTPU_fragment UART::Common_RX_Init_fragment()
     channel.TBSA = TBSA_CLR_OBE;
     channel.PDCM = PDCM_SM_ST;
     channel.IPACA = IPAC_FALLING;
-    channel.FLAG0 = 0; /* cleared, but not used currently */
+    channel.FLAG0 = 0; /* set only while edge decoding a word */
     channel.LSR = LSR_CLEAR;
     channel.TDL = TDL_CLEAR;
     channel.MRLA = MRL_CLEAR;
@@ -47,11 +59,33 @@ _eTPU_fragment UART::Common_RX_Init_fragment()
     channel.MTD = MTD_ENABLE;
     
     /* clear FIFO to start */
-    _rx_buffer_pop_p = _rx_buffer_push_p = _rx_buffer_start_p;
+    _rx_buffer_pop_p = _rx_buffer_push_p = _rx_drop_p = _rx_buffer_start_p;
+    _rx_coalesce_pending = 0;
+    if (_rx_options & (RX_OPTION_FRAME | RX_OPTION_CRC))
+    {
+        struct uart_frame_block_t* frame_block_p = _frame_block_p;
+        frame_block_p->_rx_frame_queue_pop_p = frame_block_p->_rx_frame_queue_start_p;
+        frame_block_p->_rx_frame_queue_push_p = frame_block_p->_rx_frame_queue_start_p;
+        frame_block_p->_rx_frame_active = 0;
+        frame_block_p->_rx_frame_length = 0;
+        frame_block_p->_rx_frame_errors = 0;
+        frame_block_p->_rx_crc = frame_block_p->_crc_init;
+    }
+    _rx_addressed = 0;
+    if (_rx_options & RX_OPTION_DMA)
+    {
+        _rx_dma_block_p->_byte_size = 0;
+    }
 
     /* init data mask */
     _rx_data_mask = (1 << _bit_count) - 1;
     
+    /* with auto-baud, measure the bit time before receiving */
+    if (_rx_options & RX_OPTION_AUTO_BAUD)
+    {
+        _rx_autobaud_block_p->_edge_count = 0;
+    }
+    
     /* initialize RTS pin if feature enabled */
     if (_rts_chan_num >= 0)
     {
@@ -86,82 +120,479 @@ _eTPU_thread UART::Shutdown_RX(_eTPU_matches_disabled)
 
 _eTPU_thread UART::DetectWord(_eTPU_matches_enabled)
 {
+    /* an idle timeout match may have hit along with the start bit, drop it */
+    channel.MRLA = MRL_CLEAR;
+    if ((_rx_options & RX_OPTION_FRAME) && _frame_block_p->_rx_frame_active != 0 &&
+        (int24_t)(erta - _frame_block_p->_rx_frame_end_time) >= 0)
+    {
+        /* the frame gap match hit along with this start bit and has just */
+        /* been dropped: the frame is complete all the same */
+        CloseFrame();
+    }
+    if ((_rx_options & RX_OPTION_AUTO_BAUD) && _rx_autobaud_block_p->_edge_count >= 0)
+    {
+        /* auto-baud: time the falling edges of the 0x55 sync character, */
+        /* 2 bit times apart, and 8 bit times from the first to the fifth */
+        struct uart_autobaud_block_t* autobaud_p = _rx_autobaud_block_p;
+        int24_t interval = erta - autobaud_p->_last_time;
+        autobaud_p->_last_time = erta;
+        channel.TDL = TDL_CLEAR;
+        if (autobaud_p->_edge_count == 0)
+        {
+            autobaud_p->_start_time = erta;
+            autobaud_p->_edge_count = 1;
+        }
+        else if (autobaud_p->_edge_count == 1)
+        {
+            autobaud_p->_interval = interval;
+            autobaud_p->_edge_count = 2;
+        }
+        else if (interval - autobaud_p->_interval > (autobaud_p->_interval >> 2) ||
+                 autobaud_p->_interval - interval > (autobaud_p->_interval >> 2))
+        {
+            /* edges not evenly spaced, not the sync character; */
+            /* start over with this edge as the first one */
+            autobaud_p->_start_time = erta;
+            autobaud_p->_edge_count = 1;
+        }
+        else if (++autobaud_p->_edge_count == 5)
+        {
+            interval = erta - autobaud_p->_start_time;
+            _bit_time = interval >> 3;
+            _bit_time_frac = (interval & 7) << 5;
+            /* sync character is consumed, next falling edge is a start bit */
+            autobaud_p->_edge_count = -1;
+            channel.CIRC = CIRC_INT_FROM_SERVICED;
+        }
+        return;
+    }
     _rx_one_bit = 1;
     _rx_shift_register = 0;
     _rx_parity_calc = 0;
+    _rx_start_time = erta;
     _rx_running_bit_count = _bit_count;
     if (channel.FM0 == FM0_PARITY_ENABLED)
     {
         _rx_parity_calc = _parity_select;
         _rx_running_bit_count += 1;
     }
-    erta += (_bit_time + (_bit_time >> 1));
-    channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
-    channel.IPACA = IPAC_NO_DETECT;
+    if (_rx_options & RX_OPTION_EDGE_DECODE)
+    {
+        /* edge decode: service only the transitions within the word, */
+        /* then a single match in the middle of the stop bit */
+        _rx_edge_start_time = erta;
+        _rx_edge_cell = 0;
+        _rx_edge_level = 0;
+        erta += _bit_time * (_rx_running_bit_count + 1) + (_bit_time >> 1) +
+            ((_bit_time_frac * (2 * _rx_running_bit_count + 3)) >> 9);
+        channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
+        channel.IPACA = IPAC_EITHER;
+        channel.FLAG0 = 1;
+    }
+    else
+    {
+        /* first sample 1.5 bit times out, including the fractional part */
+        int24_t frac = _bit_time_frac + (_bit_time_frac >> 1);
+        erta += (_bit_time + (_bit_time >> 1) + (frac >> 8));
+        _rx_frac_acc = frac;
+        channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
+        channel.IPACA = IPAC_NO_DETECT;
+    }
     channel.TDL = TDL_CLEAR;
 }
 
 _eTPU_thread UART::DetectBit(_eTPU_matches_enabled)
 {
     channel.MRLA = MRL_CLEAR;
-    if (_rx_running_bit_count == 0)
+    if (_rx_running_bit_count < 0)
+    {
+        /* idle timeout, coalescing latency timeout and/or frame gap, line quiet since last stop bit */
+        if (_rx_coalesce_pending != 0 && (int24_t)(erta - _rx_coalesce_start_time) >= _rx_coalesce_timeout)
+        {
+            /* first word since the last interrupt has waited long enough */
+            _rx_coalesce_pending = 0;
+            channel.CIRC = CIRC_INT_FROM_SERVICED;
+        }
+        if ((_rx_options & RX_OPTION_FRAME) && _frame_block_p->_rx_frame_active != 0 && 
+            erta == _frame_block_p->_rx_frame_end_time)
+        {
+            /* frame gap, the frame is complete */
+            CloseFrame();
+        }
+        if (_rx_idle_timeout != 0 && erta == _rx_idle_time)
+        {
+            /* interrupt host if data is waiting in FIFO */
+            if (_rx_buffer_push_p != _rx_buffer_pop_p)
+            {
+                _rx_coalesce_pending = 0;
+                channel.CIRC = CIRC_INT_FROM_SERVICED;
+            }
+        }
+        ArmIdle_fragment();
+    }
+    else if (_rx_running_bit_count == 0)
+    {
+        ReceiveStop_fragment();
+    }
+    else
+    {
+        _rx_running_bit_count -= 1;
+#ifdef __TARGET_ETPU2__
+        if (prss == 1)
+#else
+        if (pss == 1)
+#endif
+        {
+            _rx_shift_register |= _rx_one_bit;
+            _rx_parity_calc += 1;
+        }
+        _rx_one_bit <<= 1;
+        erta = erta + _bit_time;
+        if (_rx_frac_acc + _bit_time_frac > 0xff)
+        {
+            erta += 1; /* fractional part carry */
+        }
+        _rx_frac_acc += _bit_time_frac;
+        channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
+    }
+}
+
+void UART::CloseFrame()
+{
+    /* queue the complete frame and interrupt host */
+    struct uart_frame_block_t* frame_block_p = _frame_block_p;
+    struct uart_rx_frame_word_t* next_frame_p = frame_block_p->_rx_frame_queue_push_p + 1;
+    if (_rx_options & RX_OPTION_CRC)
+    {
+        /* the CRC over a frame including its CRC bytes is 0 */
+        if (frame_block_p->_rx_crc != 0)
+        {
+            frame_block_p->_rx_frame_errors |= CRC_ERROR;
+        }
+        frame_block_p->_rx_crc = frame_block_p->_crc_init;
+    }
+    if (next_frame_p == frame_block_p->_rx_frame_queue_end_p)
+    {
+        next_frame_p = frame_block_p->_rx_frame_queue_start_p;
+    }
+    if (next_frame_p == frame_block_p->_rx_frame_queue_pop_p)
+    {
+        _overrun_error = 1;
+        /* frame dropped */
+    }
+    else
+    {
+        struct uart_rx_frame_word_t* push_frame_p = frame_block_p->_rx_frame_queue_push_p;
+        push_frame_p->_error_flags = frame_block_p->_rx_frame_errors;
+        push_frame_p->_start_offset = frame_block_p->_rx_frame_start_offset;
+        push_frame_p->_length = frame_block_p->_rx_frame_length;
+        frame_block_p->_rx_frame_queue_push_p = next_frame_p;
+        channel.CIRC = CIRC_INT_FROM_SERVICED;
+    }
+    frame_block_p->_rx_frame_active = 0;
+    frame_block_p->_rx_frame_length = 0;
+    frame_block_p->_rx_frame_errors = 0;
+}
+
+struct uart_rx_data_word_t* UART::OldestRxWord(struct uart_rx_data_word_t* pop_p)
+{
+    /* overwrite-oldest policy: only the host writes pop, the eTPU keeps the end of */
+    /* the words it dropped in _rx_drop_p; the oldest word is whichever of the two */
+    /* is fewer bytes behind push */
+    int24_t pop_used = (int24_t)_rx_buffer_push_p - (int24_t)pop_p;
+    int24_t drop_used = (int24_t)_rx_buffer_push_p - (int24_t)_rx_drop_p;
+    if (pop_used < 0)
+    {
+        pop_used += _rx_buffer_byte_size;
+    }
+    if (drop_used < 0)
+    {
+        drop_used += _rx_buffer_byte_size;
+    }
+    if (drop_used < pop_used)
+    {
+        return _rx_drop_p;
+    }
+    return pop_p;
+}
+
+_eTPU_thread UART::DetectEdge(_eTPU_matches_enabled)
+{
+    int24_t cell, elapsed;
+
+    channel.TDL = TDL_CLEAR;
+    /* round the edge time to the nearest bit cell boundary, cell N */
+    /* boundary being N bit times plus N fractional parts out */
+    elapsed = (int24_t)(erta - _rx_edge_start_time);
+    cell = (elapsed + (_bit_time >> 1)) / _bit_time;
+    elapsed -= (_bit_time_frac * cell) >> 8;
+    cell = (elapsed + (_bit_time >> 1)) / _bit_time;
+    if (cell > _rx_running_bit_count + 1)
+    {
+        cell = _rx_running_bit_count + 1;
+    }
+    else if (cell < 1)
+    {
+        cell = 1; /* glitch within the start bit */
+    }
+    if (_rx_edge_level != 0)
+    {
+        /* all cells since the last edge were ones, data bit N is cell N+1 */
+        _rx_shift_register |= (1 << (cell - 1)) - (1 << (_rx_edge_cell - 1));
+        _rx_parity_calc += cell - _rx_edge_cell;
+    }
+    _rx_edge_cell = cell;
+    _rx_edge_level ^= 1;
+}
+
+_eTPU_thread UART::DetectEdgeStop(_eTPU_matches_enabled)
+{
+    int24_t cell;
+
+    channel.MRLA = MRL_CLEAR;
+    channel.TDL = TDL_CLEAR;
+    channel.FLAG0 = 0;
+    if (_rx_edge_level != 0)
     {
-        uint8_t error_flags = 0;
-        int24_t fifo_used_size;
-        struct uart_rx_data_word_t* next_p, *pop_p;
-        
-        /* this is the stop bit, check it */
+        /* the line has been high since the last edge */
+        cell = _rx_running_bit_count + 1;
+        _rx_shift_register |= (1 << (cell - 1)) - (1 << (_rx_edge_cell - 1));
+        _rx_parity_calc += cell - _rx_edge_cell;
+    }
+    _rx_running_bit_count = 0;
+    ReceiveStop_fragment();
+}
+
+_eTPU_fragment UART::ReceiveStop_fragment()
+{
+    uint8_t error_flags = 0;
+    int24_t fifo_used_size, entry_size;
+    struct uart_rx_data_word_t* word_p = _rx_buffer_push_p;
+    struct uart_rx_data_word_t* next_p, *pop_p;
+    int8_t rx_chan;
+    
+    /* this is the stop bit, check it */
 #ifdef __TARGET_ETPU2__
-        if (prss == 0)
+    if (prss == 0)
 #else
-        if (pss == 0)
+    if (pss == 0)
 #endif
+    {
+        error_flags |= FRAMING_ERROR;
+    }
+    if (channel.FM0 == FM0_PARITY_ENABLED && (_rx_parity_calc & 1) != 0)
+    {
+        error_flags |= PARITY_ERROR;
+    }
+    if (_stat_block_p != 0)
+    {
+        struct uart_stat_block_t* stat_p = _stat_block_p;
+        stat_p->_rx_count += 1;
+        if (error_flags & FRAMING_ERROR)
         {
-            error_flags |= FRAMING_ERROR;
+            stat_p->_framing_error_count += 1;
         }
-        if (channel.FM0 == FM0_PARITY_ENABLED && (_rx_parity_calc & 1) != 0)
+        if (error_flags & PARITY_ERROR)
         {
-            error_flags |= PARITY_ERROR;
+            stat_p->_parity_error_count += 1;
         }
-        /* re-enable check for start bit */
-        channel.IPACA = IPAC_FALLING;
+    }
+    /* re-enable check for start bit */
+    channel.IPACA = IPAC_FALLING;
+    _rx_idle_time = erta + _rx_idle_timeout;
+    if (_rx_options & RX_OPTION_FRAME)
+    {
+        _frame_block_p->_rx_frame_end_time = erta + _frame_block_p->_frame_gap;
+    }
 
-        /* place data into FIFO, etc. */
+    if (_rx_options & RX_OPTION_MULTIDROP)
+    {
+        /* multidrop: a word with the address mark (MSB) set selects the station(s) */
+        /* the words that follow are for; anything else is dropped right here, */
+        /* without touching the FIFO or interrupting the host */
+        if ((_rx_shift_register & (_rx_data_mask ^ (_rx_data_mask >> 1))) != 0)
+        {
+            _rx_addressed = 0;
+            if (((_rx_shift_register ^ _rx_station_address) & _rx_station_mask) == 0)
+            {
+                _rx_addressed = 1;
+            }
+        }
+        if (_rx_addressed == 0)
+        {
+            ArmIdle_fragment();
+        }
+    }
 
-        /* always put data in */
+    if (_rx_options & RX_OPTION_CRC)
+    {
+        /* CRC mode: accumulate the data bits, LSB first as received */
+        uint24_t data = _rx_shift_register;
+        uint24_t crc = _frame_block_p->_rx_crc;
+        uint24_t crc_poly = _frame_block_p->_crc_poly;
+        int8_t i;
+        for (i = 0; i < _bit_count; i++)
+        {
+            if (((crc ^ data) & 1) != 0)
+            {
+                crc = (crc >> 1) ^ crc_poly;
+            }
+            else
+            {
+                crc >>= 1;
+            }
+            data >>= 1;
+        }
+        _frame_block_p->_rx_crc = crc;
+    }
+
+    /* place data into FIFO, etc. */
+
+    /* always put data in */
+    if (_rx_options & RX_OPTION_PACKED_FIFO)
+    {
+        /* one character per byte, error flags kept in a separate map */
+        uint8_t* push_byte_p = (uint8_t*)_rx_buffer_push_p;
+        uint8_t* map_p;
+        int24_t char_index, shift;
+
+        *push_byte_p = _rx_shift_register & _rx_data_mask;
+        char_index = (int24_t)push_byte_p - (int24_t)_rx_buffer_start_p;
+        map_p = _rx_error_map_p + (char_index >> 2);
+        shift = (char_index & 3) << 1;
+        *map_p = (*map_p & ~(3 << shift)) | (error_flags << shift);
+        next_p = (struct uart_rx_data_word_t*)(push_byte_p + 1);
+    }
+    else
+    {
         _rx_buffer_push_p->_error_flags = error_flags;
         _rx_buffer_push_p->_data = _rx_shift_register & _rx_data_mask;
-
-        /* was there room in FIFO? */
-        /* error if not, otherwise increment push */
         next_p = _rx_buffer_push_p + 1;
-        pop_p = _rx_buffer_pop_p; /* sample just once */
-        if (next_p == _rx_buffer_end_p)
+        if (_rx_options & RX_OPTION_TIMESTAMP)
         {
-            next_p = _rx_buffer_start_p;
+            ((struct uart_rx_time_word_t*)next_p)->_start_time = _rx_start_time;
+            next_p += 1;
         }
+    }
+
+    /* was there room in FIFO? */
+    /* error if not, otherwise increment push */
+    pop_p = _rx_buffer_pop_p; /* sample just once */
+    if (_rx_options & RX_OPTION_OVERWRITE)
+    {
+        pop_p = OldestRxWord(pop_p);
+    }
+    entry_size = (int24_t)next_p - (int24_t)word_p;
+    if (next_p == _rx_buffer_end_p)
+    {
+        next_p = _rx_buffer_start_p;
+    }
+    if (_rx_options & RX_OPTION_OVERWRITE)
+    {
         if (next_p == pop_p)
         {
+            /* freshest wins: drop the oldest word to make room for this one */
             _overrun_error = 1;
-            /* just exit (data dropped) */
-            return;
+            if (_stat_block_p != 0)
+            {
+                _stat_block_p->_rx_overrun_count += 1;
+            }
+            pop_p = (struct uart_rx_data_word_t*)((int24_t)pop_p + entry_size);
+            if (pop_p == _rx_buffer_end_p)
+            {
+                pop_p = _rx_buffer_start_p;
+            }
         }
+        /* the host moves pop past the dropped words when it next commits; this */
+        /* also brings _rx_drop_p up to the host pop once that is ahead, before */
+        /* push moves on and could pass it */
+        _rx_drop_p = pop_p;
+    }
+    if (next_p == pop_p)
+    {
+        _overrun_error = 1;
+        /* data dropped */
+        if (_stat_block_p != 0)
+        {
+            _stat_block_p->_rx_overrun_count += 1;
+        }
+        if (_rx_options & RX_OPTION_FRAME)
+        {
+            _frame_block_p->_rx_frame_errors |= FRAME_OVERRUN_ERROR;
+            _frame_block_p->_rx_frame_active = 1;
+        }
+    }
+    else
+    {
         _rx_buffer_push_p = next_p;
-        
+    
         /* issue interrupt if threshold reached */
         fifo_used_size = (int24_t)next_p - (int24_t)pop_p;
         if (fifo_used_size < 0)
         {
             fifo_used_size += _rx_buffer_byte_size;
         }
-        if (fifo_used_size == _rx_fifo_int_threshold)
+        if (_stat_block_p != 0 && fifo_used_size > _stat_block_p->_rx_fifo_high_water)
+        {
+            _stat_block_p->_rx_fifo_high_water = fifo_used_size;
+        }
+        if (_rx_options & RX_OPTION_DMA)
+        {
+            /* DMA mode: once the previous block has been committed by the host, */
+            /* hand over the next contiguous block (up to threshold size) instead */
+            if (fifo_used_size >= _rx_fifo_int_threshold && _rx_dma_block_p->_byte_size == 0)
+            {
+                int24_t block_size = (int24_t)next_p - (int24_t)pop_p;
+                if (block_size < 0)
+                {
+                    block_size = (int24_t)_rx_buffer_end_p - (int24_t)pop_p;
+                }
+                if (block_size > _rx_fifo_int_threshold)
+                {
+                    block_size = _rx_fifo_int_threshold;
+                }
+                _rx_dma_block_p->_sys_addr = _dma_sys_base + (int24_t)pop_p;
+                _rx_dma_block_p->_byte_size = block_size;
+                channel.CIRC = CIRC_DATA_FROM_SERVICED;
+            }
+        }
+        else if (_rx_options & RX_OPTION_FRAME)
+        {
+            /* frame mode: track the frame, the host is interrupted once it is complete */
+            struct uart_frame_block_t* frame_block_p = _frame_block_p;
+            if (frame_block_p->_rx_frame_length == 0)
+            {
+                frame_block_p->_rx_frame_start_offset = (int24_t)word_p - (int24_t)_rx_buffer_start_p;
+            }
+            frame_block_p->_rx_frame_length += 1;
+            frame_block_p->_rx_frame_errors |= error_flags;
+            frame_block_p->_rx_frame_active = 1;
+        }
+        else if (_rx_coalesce_timeout != 0)
+        {
+            /* coalescing: one interrupt per count of words received, or once */
+            /* the first of them has waited the latency timeout */
+            if (_rx_coalesce_pending == 0)
+            {
+                _rx_coalesce_start_time = erta;
+            }
+            _rx_coalesce_pending += 1;
+            if (_rx_coalesce_pending >= _rx_coalesce_count ||
+                (int24_t)(erta - _rx_coalesce_start_time) >= _rx_coalesce_timeout)
+            {
+                _rx_coalesce_pending = 0;
+                channel.CIRC = CIRC_INT_FROM_SERVICED;
+            }
+        }
+        else if (fifo_used_size == _rx_fifo_int_threshold)
         {
             channel.CIRC = CIRC_INT_FROM_SERVICED;
         }
-        
+    
         /* update RTS output if feature enabled and threshold crossed */
         if (_rts_chan_num >= 0)
         {
+            rx_chan = chan;
             chan = _rts_chan_num;
             if (fifo_used_size >= _rx_rts_halt_threshold)
             {
@@ -171,22 +602,45 @@ _eTPU_thread UART::DetectBit(_eTPU_matches_enabled)
             {
                 channel.PIN = PIN_SET_LOW;
             }
+            chan = rx_chan;
         }
     }
-    else
+    ArmIdle_fragment();
+}
+
+_eTPU_fragment UART::ArmIdle_fragment()
+{
+    int24_t match_time = 0, latency_time;
+    _Bool armed = 0;
+
+    /* arm one match for whichever of the idle timeout, the coalescing */
+    /* latency timeout and the frame gap comes first, a start bit replaces it */
+    if (_rx_idle_timeout != 0 && (int24_t)(_rx_idle_time - erta) > 0)
     {
-        _rx_running_bit_count -= 1;
-#ifdef __TARGET_ETPU2__
-        if (prss == 1)
-#else
-        if (pss == 1)
-#endif
+        match_time = _rx_idle_time;
+        armed = 1;
+    }
+    if (_rx_coalesce_pending != 0)
+    {
+        latency_time = _rx_coalesce_start_time + _rx_coalesce_timeout;
+        if (armed == 0 || (int24_t)(latency_time - match_time) < 0)
         {
-            _rx_shift_register |= _rx_one_bit;
-            _rx_parity_calc += 1;
+            match_time = latency_time;
+            armed = 1;
         }
-        _rx_one_bit <<= 1;
-        erta = erta + _bit_time;
+    }
+    if ((_rx_options & RX_OPTION_FRAME) && _frame_block_p->_rx_frame_active != 0)
+    {
+        if (armed == 0 || (int24_t)(_frame_block_p->_rx_frame_end_time - match_time) < 0)
+        {
+            match_time = _frame_block_p->_rx_frame_end_time;
+            armed = 1;
+        }
+    }
+    if (armed)
+    {
+        _rx_running_bit_count = -1;
+        erta = match_time;
         channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
     }
 }
@@ -194,10 +648,15 @@ _eTPU_thread UART::DetectBit(_eTPU_matches_enabled)
 _eTPU_thread UART::UpdateRTS(_eTPU_matches_enabled)
 {
     int24_t fifo_used_size;
+    struct uart_rx_data_word_t* pop_p = _rx_buffer_pop_p;
 
     if (_rts_chan_num >= 0)
     {
-        fifo_used_size = (int24_t)_rx_buffer_push_p - (int24_t)_rx_buffer_pop_p;
+        if (_rx_options & RX_OPTION_OVERWRITE)
+        {
+            pop_p = OldestRxWord(pop_p);
+        }
+        fifo_used_size = (int24_t)_rx_buffer_push_p - (int24_t)pop_p;
         if (fifo_used_size < 0)
         {
             fifo_used_size += _rx_buffer_byte_size;
@@ -232,24 +691,24 @@ DEFINE_ENTRY_TABLE(UART, UART_RX, standard, inputpin, autocfsr)
 	ETPU_VECTOR1(0,  1,  1, 1, x,  0, x, _Error_handler_unexpected_thread),
 	ETPU_VECTOR1(0,  1,  1, 1, x,  1, x, _Error_handler_unexpected_thread),
 	ETPU_VECTOR1(0,  0,  0, 1, 0,  0, x, DetectWord),
-	ETPU_VECTOR1(0,  0,  0, 1, 0,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(0,  0,  0, 1, 0,  1, x, DetectEdge),
 	ETPU_VECTOR1(0,  0,  0, 1, 1,  0, x, DetectWord),
-	ETPU_VECTOR1(0,  0,  0, 1, 1,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(0,  0,  0, 1, 1,  1, x, DetectEdge),
 	ETPU_VECTOR1(0,  0,  1, 0, 0,  0, x, DetectBit),
-	ETPU_VECTOR1(0,  0,  1, 0, 0,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(0,  0,  1, 0, 0,  1, x, DetectEdgeStop),
 	ETPU_VECTOR1(0,  0,  1, 0, 1,  0, x, DetectBit),
-	ETPU_VECTOR1(0,  0,  1, 0, 1,  1, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  0,  1, 1, 0,  0, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  0,  1, 1, 0,  1, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  0,  1, 1, 1,  0, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  0,  1, 1, 1,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(0,  0,  1, 0, 1,  1, x, DetectEdgeStop),
+	ETPU_VECTOR1(0,  0,  1, 1, 0,  0, x, DetectWord),
+	ETPU_VECTOR1(0,  0,  1, 1, 0,  1, x, DetectEdgeStop),
+	ETPU_VECTOR1(0,  0,  1, 1, 1,  0, x, DetectWord),
+	ETPU_VECTOR1(0,  0,  1, 1, 1,  1, x, DetectEdgeStop),
 	ETPU_VECTOR1(0,  1,  0, 0, 0,  0, x, _Error_handler_unexpected_thread),
 	ETPU_VECTOR1(0,  1,  0, 0, 0,  1, x, _Error_handler_unexpected_thread),
 	ETPU_VECTOR1(0,  1,  0, 0, 1,  0, x, _Error_handler_unexpected_thread),
 	ETPU_VECTOR1(0,  1,  0, 0, 1,  1, x, _Error_handler_unexpected_thread),
 	ETPU_VECTOR1(0,  1,  0, 1, x,  0, x, DetectWord),
-	ETPU_VECTOR1(0,  1,  0, 1, x,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(0,  1,  0, 1, x,  1, x, DetectEdge),
 	ETPU_VECTOR1(0,  1,  1, 0, x,  0, x, DetectBit),
-	ETPU_VECTOR1(0,  1,  1, 0, x,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(0,  1,  1, 0, x,  1, x, DetectEdgeStop),
 };
 
@@ -16,10 +16,24 @@
 /* provide hint that channel frame base addr same on all chans touched by func */
 #pragma same_channel_frame_base UART_TX
 
+#pragma export_autodef_macro "ETPU_UART_TX_WAKE_TCR1_HSR", 1
 #pragma export_autodef_macro "ETPU_UART_TX_INIT_TCR1_HSR", 2
+#pragma export_autodef_macro "ETPU_UART_TX_WAKE_TCR2_HSR", 3
 #pragma export_autodef_macro "ETPU_UART_TX_INIT_TCR2_HSR", 4
 #pragma export_autodef_macro "ETPU_UART_TX_SHUTDOWN_HSR", 7
 
+#pragma export_autodef_macro "ETPU_UART_TX_OPTION_PACKED_FIFO", TX_OPTION_PACKED_FIFO
+#pragma export_autodef_macro "ETPU_UART_TX_OPTION_DMA", TX_OPTION_DMA
+#pragma export_autodef_macro "ETPU_UART_TX_OPTION_RUN_LENGTH", TX_OPTION_RUN_LENGTH
+#pragma export_autodef_macro "ETPU_UART_TX_OPTION_FRAME", TX_OPTION_FRAME
+#pragma export_autodef_macro "ETPU_UART_TX_OPTION_CRC", TX_OPTION_CRC
+#pragma export_autodef_macro "ETPU_UART_TX_OPTION_IDLE_PARK", TX_OPTION_IDLE_PARK
+#pragma export_autodef_macro "ETPU_UART_TX_OPTION_TIMED", TX_OPTION_TIMED
+
+/* TX_END_OF_FRAME and TX_START_TIME in the MSB of a TX FIFO word */
+#pragma export_autodef_macro "ETPU_UART_TX_END_OF_FRAME", 0x01000000
+#pragma export_autodef_macro "ETPU_UART_TX_START_TIME", 0x02000000
+
 
 _eTPU_thread UART::Init_TX_TCR1(_eTPU_matches_disabled)
 {
@@ -56,6 +70,24 @@ _eTPU_fragment UART::Common_TX_Init_fragment()
 
     /* clear FIFO to start */
     _tx_buffer_pop_p = _tx_buffer_push_p = _tx_buffer_start_p;
+    _tx_dma_pending_size = 0;
+    _tx_dma_remaining_size = 0;
+    if (_tx_options & (TX_OPTION_FRAME | TX_OPTION_CRC))
+    {
+        struct uart_frame_block_t* frame_block_p = _frame_block_p;
+        frame_block_p->_tx_frame_state = TX_FRAME_IN_FRAME;
+        frame_block_p->_tx_crc = frame_block_p->_crc_init;
+        frame_block_p->_tx_crc_bytes_left = 0;
+    }
+    if (_stat_block_p != 0)
+    {
+        _stat_block_p->_tx_cts_stalled = 0;
+    }
+    _tx_parked = 0;
+    if (_tx_options & TX_OPTION_DMA)
+    {
+        _tx_dma_block_p->_byte_size = 0;
+    }
     
     if (_cts_chan_num >= 0)
     {
@@ -103,12 +135,115 @@ _eTPU_thread UART::TransmitCheck(_eTPU_matches_enabled)
 {
     uint24_t* pop_p, * push_p;
     int24_t fifo_used_size;
+    int24_t check_time = erta;
+    struct uart_frame_block_t* frame_block_p = _frame_block_p;
+    int8_t crc_bytes_left = 0;
 
     channel.MRLA = MRL_CLEAR;
     erta += _stop_time;
     channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
-    if ((pop_p = _tx_buffer_pop_p) != (push_p = _tx_buffer_push_p))
+    if ((_tx_options & TX_OPTION_FRAME) && frame_block_p->_tx_frame_state == TX_FRAME_LAST_WORD)
+    {
+        /* the word ending the frame is out, the inter-frame gap starts now */
+        frame_block_p->_tx_frame_state = TX_FRAME_GAP;
+        frame_block_p->_tx_frame_end_time = check_time;
+    }
+    if (_tx_options & TX_OPTION_CRC)
+    {
+        crc_bytes_left = frame_block_p->_tx_crc_bytes_left;
+    }
+    if (_tx_options & TX_OPTION_DMA)
+    {
+        /* DMA mode: the DMA clears the descriptor size once it has filled */
+        /* the requested block, which then gets pushed onto the FIFO here */
+        int24_t block_size;
+        push_p = _tx_buffer_push_p;
+        if (_tx_dma_pending_size != 0 && _tx_dma_block_p->_byte_size == 0)
+        {
+            block_size = _tx_dma_pending_size;
+            _tx_dma_pending_size = 0;
+            push_p = (uint24_t*)((int24_t)push_p + block_size);
+            if (push_p == _tx_buffer_end_p)
+            {
+                push_p = _tx_buffer_start_p;
+            }
+            _tx_buffer_push_p = push_p;
+            _tx_dma_src_addr += block_size;
+            if ((_tx_dma_remaining_size -= block_size) == 0)
+            {
+                /* whole host buffer is in the FIFO, signal completion */
+                channel.CIRC = CIRC_INT_FROM_SERVICED;
+            }
+        }
+        /* request the next block once at or below threshold and it fits */
+        if (_tx_dma_pending_size == 0 && _tx_dma_remaining_size > 0)
+        {
+            fifo_used_size = (int24_t)push_p - (int24_t)_tx_buffer_pop_p;
+            if (fifo_used_size < 0)
+            {
+                fifo_used_size += _tx_buffer_byte_size;
+            }
+            block_size = _tx_dma_block_byte_size;
+            if (block_size > _tx_dma_remaining_size)
+            {
+                block_size = _tx_dma_remaining_size;
+            }
+            if (block_size > (int24_t)_tx_buffer_end_p - (int24_t)push_p)
+            {
+                block_size = (int24_t)_tx_buffer_end_p - (int24_t)push_p;
+            }
+            if (fifo_used_size <= _tx_fifo_int_threshold &&
+                fifo_used_size + block_size < _tx_buffer_byte_size)
+            {
+                _tx_dma_block_p->_dst_addr = _dma_sys_base + (int24_t)push_p;
+                _tx_dma_block_p->_src_addr = _tx_dma_src_addr;
+                _tx_dma_block_p->_byte_size = block_size;
+                _tx_dma_pending_size = block_size;
+                channel.CIRC = CIRC_DATA_FROM_SERVICED;
+            }
+        }
+    }
+    pop_p = _tx_buffer_pop_p;
+    push_p = _tx_buffer_push_p;
+    if (pop_p != push_p || crc_bytes_left != 0)
     {
+        if ((_tx_options & TX_OPTION_TIMED) && crc_bytes_left == 0 &&
+            (*(uint8_t*)pop_p & TX_START_TIME) != 0)
+        {
+            /* timed entry: keep the line idle, so that the start bit of the next */
+            /* word falls at the start time, one stop time after the next check */
+            int24_t start_time = *pop_p;
+            int24_t stop_end_time = erta;
+            pop_p += 1;
+            if (pop_p == _tx_buffer_end_p)
+            {
+                pop_p = _tx_buffer_start_p;
+            }
+            _tx_buffer_pop_p = pop_p;
+            channel.MRLA = MRL_CLEAR;
+            erta = start_time - _stop_time;
+            channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
+            /* TX enable post delay runs from the end of the last stop bit */
+            erta = stop_end_time;
+            FinishTXE_fragment();
+        }
+        if ((_tx_options & TX_OPTION_FRAME) && frame_block_p->_tx_frame_state == TX_FRAME_GAP)
+        {
+            /* the last stop bit of the frame ends one stop time after _tx_frame_end_time, */
+            /* and the start bit of this word goes out one stop time after check_time, */
+            /* so the silence in between is check_time - _tx_frame_end_time: it must be */
+            /* _frame_gap at least, a start bit at end time + _frame_gap + _stop_time */
+            if ((int24_t)(check_time - frame_block_p->_tx_frame_end_time) < frame_block_p->_frame_gap)
+            {
+                /* next frame must wait for the end of the inter-frame gap */
+                channel.MRLA = MRL_CLEAR;
+                erta = frame_block_p->_tx_frame_end_time + frame_block_p->_frame_gap;
+                channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
+                return;
+            }
+            frame_block_p->_tx_frame_state = TX_FRAME_IN_FRAME;
+        }
+
         /* if CTS enabled and not active, do not send */
         if (_cts_chan_num >= 0)
         {
@@ -117,11 +252,20 @@ _eTPU_thread UART::TransmitCheck(_eTPU_matches_enabled)
             if (channel.PSTI == 1)
             {
                 /* not clear to send, must wait */
+                if (_stat_block_p != 0 && _stat_block_p->_tx_cts_stalled == 0)
+                {
+                    _stat_block_p->_tx_cts_stalled = 1;
+                    _stat_block_p->_cts_stall_count += 1;
+                }
                 /* perform TXE end processing as needed and exit */
                 chan = tmp;
                 FinishTXE_fragment();
             }
             chan = tmp;
+            if (_stat_block_p != 0)
+            {
+                _stat_block_p->_tx_cts_stalled = 0;
+            }
         }
         
         /* if in 485 mode, update tx enable */
@@ -139,28 +283,151 @@ _eTPU_thread UART::TransmitCheck(_eTPU_matches_enabled)
         channel.FLAG0 = 1;
         _tx_parity_calc = _parity_select;
         _tx_running_bit_count = _bit_count;
-        _tx_shift_register = *_tx_buffer_pop_p;
-        
-        /* update pop ptr and interrupt host if necessary */
-        pop_p += 1;
-        if (pop_p == _tx_buffer_end_p)
+        _tx_frac_acc = 0;
+        if (_stat_block_p != 0)
         {
-            pop_p = _tx_buffer_start_p;
+            _stat_block_p->_tx_count += 1;
         }
-        _tx_buffer_pop_p = pop_p;
         
-        fifo_used_size = (int24_t)push_p - (int24_t)pop_p;
-        if (fifo_used_size < 0)
+        if (crc_bytes_left != 0)
         {
-            fifo_used_size += _tx_buffer_byte_size;
+            /* CRC mode: append the frame CRC, low byte first */
+            _tx_shift_register = frame_block_p->_tx_crc & 0xff;
+            frame_block_p->_tx_crc >>= 8;
+            frame_block_p->_tx_crc_bytes_left = crc_bytes_left - 1;
+            if (crc_bytes_left == 1)
+            {
+                frame_block_p->_tx_crc = frame_block_p->_crc_init;
+                if (_tx_options & TX_OPTION_FRAME)
+                {
+                    frame_block_p->_tx_frame_state = TX_FRAME_LAST_WORD;
+                }
+            }
+        }
+        else
+        {
+            fifo_used_size = (int24_t)push_p - (int24_t)pop_p;
+            if (fifo_used_size < 0)
+            {
+                fifo_used_size += _tx_buffer_byte_size;
+            }
+            if (_stat_block_p != 0 && fifo_used_size > _stat_block_p->_tx_fifo_high_water)
+            {
+                _stat_block_p->_tx_fifo_high_water = fifo_used_size;
+            }
+            
+            /* get the next word, update pop ptr and interrupt host if necessary */
+            if (_tx_options & TX_OPTION_PACKED_FIFO)
+            {
+                /* packed FIFO, one character per byte */
+                _tx_shift_register = *(uint8_t*)pop_p;
+                pop_p = (uint24_t*)((uint8_t*)pop_p + 1);
+            }
+            else
+            {
+                _tx_shift_register = *pop_p;
+                if ((*(uint8_t*)pop_p & TX_END_OF_FRAME) != 0)
+                {
+                    if (_tx_options & TX_OPTION_CRC)
+                    {
+                        frame_block_p->_tx_crc_bytes_left = 2;
+                    }
+                    else if (_tx_options & TX_OPTION_FRAME)
+                    {
+                        frame_block_p->_tx_frame_state = TX_FRAME_LAST_WORD;
+                    }
+                }
+                pop_p += 1;
+            }
+            if (pop_p == _tx_buffer_end_p)
+            {
+                pop_p = _tx_buffer_start_p;
+            }
+            _tx_buffer_pop_p = pop_p;
+            
+            if (_tx_options & TX_OPTION_CRC)
+            {
+                /* CRC mode: accumulate the data bits, LSB first as sent */
+                uint24_t data = _tx_shift_register;
+                uint24_t crc = frame_block_p->_tx_crc;
+                uint24_t crc_poly = frame_block_p->_crc_poly;
+                int8_t i;
+                for (i = 0; i < _bit_count; i++)
+                {
+                    if (((crc ^ data) & 1) != 0)
+                    {
+                        crc = (crc >> 1) ^ crc_poly;
+                    }
+                    else
+                    {
+                        crc >>= 1;
+                    }
+                    data >>= 1;
+                }
+                frame_block_p->_tx_crc = crc;
+            }
+            
+            fifo_used_size = (int24_t)push_p - (int24_t)pop_p;
+            if (fifo_used_size < 0)
+            {
+                fifo_used_size += _tx_buffer_byte_size;
+            }
+            if (fifo_used_size == _tx_fifo_int_threshold && (_tx_options & TX_OPTION_DMA) == 0)
+            {
+                channel.CIRC = CIRC_INT_FROM_SERVICED;
+            }
         }
-        if (fifo_used_size == _tx_fifo_int_threshold)
+        
+        if (_tx_options & TX_OPTION_RUN_LENGTH)
         {
-            channel.CIRC = CIRC_INT_FROM_SERVICED;
+            /* run-length mode: mask the data bits and append the parity bit */
+            uint24_t frame = 0, one_bit = 1;
+            int8_t i;
+            for (i = 0; i < _bit_count; i++)
+            {
+                if ((_tx_shift_register & one_bit) != 0)
+                {
+                    frame |= one_bit;
+                    _tx_parity_calc += 1;
+                }
+                one_bit <<= 1;
+            }
+            if (channel.FM0 == FM0_PARITY_ENABLED)
+            {
+                if ((_tx_parity_calc & 1) != 0)
+                {
+                    frame |= one_bit;
+                }
+                _tx_running_bit_count += 1;
+            }
+            _tx_shift_register = frame;
+            _tx_level = 0; /* start bit */
         }
     }
     else
     {
+        if ((_tx_options & TX_OPTION_FRAME) && frame_block_p->_tx_frame_state == TX_FRAME_IN_FRAME)
+        {
+            /* TX FIFO ran empty, this ends the frame */
+            frame_block_p->_tx_frame_state = TX_FRAME_GAP;
+            frame_block_p->_tx_frame_end_time = check_time;
+        }
+        if (_tx_options & TX_OPTION_IDLE_PARK)
+        {
+            /* idle park: stop polling until the host pushes data and wakes the channel; */
+            /* flag the park before looking at the push pointer again, the host pushes */
+            /* before reading the flag, so either side sees the other */
+            _tx_parked = 1;
+            if (_tx_buffer_push_p != pop_p)
+            {
+                /* data pushed meanwhile, keep polling */
+                _tx_parked = 0;
+            }
+            else
+            {
+                channel.MRLE = MRLE_DISABLE;
+            }
+        }
         FinishTXE_fragment();
     }
 }
@@ -179,8 +446,79 @@ _eTPU_fragment UART::FinishTXE_fragment()
     }
 }
 
+_eTPU_thread UART::Wake_TX_TCR1(_eTPU_matches_disabled)
+{
+    if (_tx_parked != 0)
+    {
+        erta = tcr1;
+        Wake_TX_fragment();
+    }
+}
+
+_eTPU_thread UART::Wake_TX_TCR2(_eTPU_matches_disabled)
+{
+    if (_tx_parked != 0)
+    {
+        erta = tcr2;
+        Wake_TX_fragment();
+    }
+}
+
+_eTPU_fragment UART::Wake_TX_fragment()
+{
+    /* the host has pushed data onto the empty TX FIFO, check it right away; */
+    /* a wake request while not parked is ignored, the TX check is running */
+    /* and has seen the push */
+    _tx_parked = 0;
+    channel.MRLA = MRL_CLEAR;
+    channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
+}
+
 _eTPU_thread UART::TransmitBit(_eTPU_matches_enabled)
 {
+    if (_tx_options & TX_OPTION_RUN_LENGTH)
+    {
+        /* run-length mode: skip the bits at the current level and */
+        /* schedule a single match for the next level change */
+        int24_t run_time = _bit_time;
+        if (_tx_frac_acc + _bit_time_frac > 0xff)
+        {
+            run_time += 1; /* fractional part carry */
+        }
+        _tx_frac_acc += _bit_time_frac;
+        while (_tx_running_bit_count > 0 && (_tx_shift_register & 1) == _tx_level)
+        {
+            run_time += _bit_time;
+            if (_tx_frac_acc + _bit_time_frac > 0xff)
+            {
+                run_time += 1;
+            }
+            _tx_frac_acc += _bit_time_frac;
+            _tx_shift_register >>= 1;
+            _tx_running_bit_count -= 1;
+        }
+        if (_tx_running_bit_count > 0)
+        {
+            _tx_level ^= 1;
+            _tx_shift_register >>= 1;
+            _tx_running_bit_count -= 1;
+            channel.OPACA = OPAC_MATCH_LOW;
+            if (_tx_level != 0)
+            {
+                channel.OPACA = OPAC_MATCH_HIGH;
+            }
+        }
+        else
+        {
+            /* rest of the word is at stop level, next match is start of stop bit */
+            channel.OPACA = OPAC_MATCH_HIGH;
+            channel.FLAG0 = 0;
+        }
+        channel.MRLA = MRL_CLEAR;
+        erta = erta + run_time;
+        channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
+        return;
+    }
     if (_tx_running_bit_count == 0)
     {
         if (channel.FM0 == FM0_PARITY_DISABLED)
@@ -215,6 +553,11 @@ _eTPU_thread UART::TransmitBit(_eTPU_matches_enabled)
     _tx_shift_register >>= 1;
     channel.MRLA = MRL_CLEAR;
     erta = erta + _bit_time;
+    if (_tx_frac_acc + _bit_time_frac > 0xff)
+    {
+        erta += 1; /* fractional part carry */
+    }
+    _tx_frac_acc += _bit_time_frac;
     channel.ERWA = ERW_WRITE_ERT_TO_MATCH;
 }
 
@@ -223,12 +566,12 @@ _eTPU_thread UART::TransmitBit(_eTPU_matches_enabled)
 DEFINE_ENTRY_TABLE(UART, UART_TX, standard, outputpin, autocfsr)
 {
 	//           HSR LSR M1 M2 PIN F0 F1 vector
-	ETPU_VECTOR1(1,  x,  x, x, 0,  0, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(1,  x,  x, x, 0,  1, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(1,  x,  x, x, 1,  0, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(1,  x,  x, x, 1,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(1,  x,  x, x, 0,  0, x, Wake_TX_TCR1),
+	ETPU_VECTOR1(1,  x,  x, x, 0,  1, x, Wake_TX_TCR1),
+	ETPU_VECTOR1(1,  x,  x, x, 1,  0, x, Wake_TX_TCR1),
+	ETPU_VECTOR1(1,  x,  x, x, 1,  1, x, Wake_TX_TCR1),
 	ETPU_VECTOR1(2,  x,  x, x, x,  x, x, Init_TX_TCR1),
-	ETPU_VECTOR1(3,  x,  x, x, x,  x, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(3,  x,  x, x, x,  x, x, Wake_TX_TCR2),
 	ETPU_VECTOR1(4,  x,  x, x, x,  x, x, Init_TX_TCR2),
 	ETPU_VECTOR1(5,  x,  x, x, x,  x, x, _Error_handler_unexpected_thread),
 	ETPU_VECTOR1(6,  x,  x, x, x,  x, x, _Error_handler_unexpected_thread),
@@ -9,53 +9,422 @@
 #include "etpu_uart.h"          /* eTPU UART API header */
 
 
-int32_t etpu_uart_init(
+/* size in bytes of one RX FIFO entry */
+static uint32_t etpu_uart_rx_entry_size(
+    struct uart_config_t   *p_uart_config)
+{
+    if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_PACKED_FIFO)
+        return 1;
+    if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_TIMESTAMP)
+        return 8;
+    return 4;
+}
+
+/* size in bytes of one TX FIFO entry */
+static uint32_t etpu_uart_tx_entry_size(
+    struct uart_config_t   *p_uart_config)
+{
+    if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_PACKED_FIFO)
+        return 1;
+    return 4;
+}
+
+/* the packed RX FIFO is rounded up to whole words and followed by its error map */
+static uint32_t etpu_uart_rx_fifo_alloc_size(
+    struct uart_config_t   *p_uart_config)
+{
+    if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_PACKED_FIFO)
+        return ((p_uart_config->rx_fifo_word_size + 3) & ~3) + (((p_uart_config->rx_fifo_word_size + 15) >> 4) << 2);
+    return p_uart_config->rx_fifo_word_size * etpu_uart_rx_entry_size(p_uart_config);
+}
+
+static uint8_t* etpu_uart_rx_error_map(
     struct uart_instance_t *p_uart_instance,
     struct uart_config_t   *p_uart_config)
 {
-    volatile struct eTPU_struct * eTPU;
-    uint32_t timer_freq;
-    uint8_t init_chan_num = 0xff;
-    uint32_t bit_time;
+    return (uint8_t*)p_uart_instance->rx_fifo_buffer + ((p_uart_config->rx_fifo_word_size + 3) & ~3);
+}
+
+/* copy 32-bit words, 4 per loop iteration */
+static void etpu_uart_copy32(
+    uint32_t               *p_dest,
+    const uint32_t         *p_source,
+    int32_t                 word_cnt)
+{
+    while (word_cnt >= 4)
+    {
+        p_dest[0] = p_source[0];
+        p_dest[1] = p_source[1];
+        p_dest[2] = p_source[2];
+        p_dest[3] = p_source[3];
+        p_dest += 4;
+        p_source += 4;
+        word_cnt -= 4;
+    }
+    while (word_cnt-- > 0)
+        *p_dest++ = *p_source++;
+}
+
+/* get the register block of the eTPU engine the UART runs on */
+static volatile struct eTPU_struct * etpu_uart_engine(
+    ETPU_MODULE             em)
+{
+    if (em == EM_AB)
+        return eTPU_AB;
+    return eTPU_C;
+}
+
+/* get the overrun error status if requested (clear if read) */
+static void etpu_uart_rx_overrun_status(
+    struct uart_instance_t *p_uart_instance,
+    uint32_t               *p_overrun_error_status)
+{
+    if (p_overrun_error_status != 0)
+    {
+        *p_overrun_error_status = (uint32_t)((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_overrun_error;
+        if (*p_overrun_error_status != 0)
+            ((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_overrun_error = 0; /* clear it */
+    }
+}
+
+/* get the RX FIFO pop position (oldest word); with the overwrite-oldest policy only the host writes pop,
+   the eTPU keeps the end of the words it dropped in _rx_drop_p, and the oldest word is whichever of the
+   two is fewer bytes behind push - push is read first, the eTPU moves _rx_drop_p before push */
+static uint32_t etpu_uart_rx_pop_p(
+    struct uart_instance_t *p_uart_instance)
+{
+    etpu_if_UART_CHANNEL_FRAME_PSE *p_frame = (etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse;
+    uint32_t pop_p, drop_p;
+    int32_t push_p, pop_used, drop_used;
+
+    if ((p_frame->_rx_options & ETPU_UART_RX_OPTION_OVERWRITE) == 0)
+        return p_frame->_rx_buffer_pop_p;
+    push_p = (int32_t)p_frame->_rx_buffer_push_p;
+    pop_p = p_frame->_rx_buffer_pop_p;
+    drop_p = p_frame->_rx_drop_p;
+    pop_used = push_p - (int32_t)pop_p;
+    if (pop_used < 0)
+        pop_used += p_frame->_rx_buffer_byte_size;
+    drop_used = push_p - (int32_t)drop_p;
+    if (drop_used < 0)
+        drop_used += p_frame->_rx_buffer_byte_size;
+    return (drop_used < pop_used) ? drop_p : pop_p;
+}
+
+/* commit a new RX FIFO pop position, read as old_pop_p, let the eTPU re-evaluate RTS if needed, and get
+   the overrun status; returns 1 without committing if the eTPU has dropped words past old_pop_p since 
+   (overwrite-oldest policy), in which case the entries read from old_pop_p may have been overwritten and
+   must be read again */
+static int32_t etpu_uart_rx_update_pop(
+    struct uart_instance_t *p_uart_instance,
+    uint32_t                old_pop_p,
+    void                   *pop_addr,
+    uint32_t               *p_overrun_error_status)
+{
+    volatile struct eTPU_struct * eTPU = etpu_uart_engine(p_uart_instance->em);
+    etpu_if_UART_CHANNEL_FRAME_PSE *p_frame = (etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse;
+    uint32_t new_pop_p = (uint32_t)pop_addr & 0x3fff;
+    int32_t old_used, new_used;
+
+    if (etpu_uart_rx_pop_p(p_uart_instance) != old_pop_p)
+        return 1;
+    /* a word dropped by the eTPU from here on only moves _rx_drop_p one entry past old_pop_p, 
+       which the new pop position covers, so pop is only written when it moves forward */
+    if (new_pop_p == old_pop_p)
+    {
+        etpu_uart_rx_overrun_status(p_uart_instance, p_overrun_error_status);
+        return 0;
+    }
+    if (p_uart_instance->rts_chan_num != 0xff && p_uart_instance->rx_chan_num != 0xff)
+    {
+        /* RTS is only ever released by the UpdateRTS HSR once the FIFO drains to the resume threshold,
+           so the HSR is only needed when this pop crosses it - the eTPU handles the halt side itself */
+        old_used = (int32_t)p_frame->_rx_buffer_push_p - (int32_t)old_pop_p;
+        if (old_used < 0)
+            old_used += p_frame->_rx_buffer_byte_size;
+        new_used = (int32_t)p_frame->_rx_buffer_push_p - (int32_t)new_pop_p;
+        if (new_used < 0)
+            new_used += p_frame->_rx_buffer_byte_size;
+        p_frame->_rx_buffer_pop_p = new_pop_p;
+        if (old_used > p_frame->_rx_rts_resume_threshold && new_used <= p_frame->_rx_rts_resume_threshold)
+            eTPU->CHAN[p_uart_instance->rx_chan_num].HSRR.R = ETPU_UART_RX_UPDATE_RTS_HSR;
+    }
+    else
+    {
+        p_frame->_rx_buffer_pop_p = new_pop_p;
+    }
+    
+    etpu_uart_rx_overrun_status(p_uart_instance, p_overrun_error_status);
+    return 0;
+}
+
+/* idle park mode: wake a parked TX channel after a push onto its TX FIFO - the push is written
+   before the park flag is read, and the eTPU sets the flag before reading the push pointer again,
+   so either the eTPU keeps polling or the flag is seen here (a wake request finding the channel
+   polling again is ignored by the eTPU) */
+static void etpu_uart_tx_wake(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config)
+{
+    volatile struct eTPU_struct * eTPU = etpu_uart_engine(p_uart_instance->em);
 
+    if ((p_uart_config->tx_options & ETPU_UART_TX_OPTION_IDLE_PARK) == 0 || p_uart_instance->tx_chan_num == 0xff)
+        return;
+    if (((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_tx_parked != 0)
+    {
+        if (p_uart_config->timer == FS_ETPU_TCR1)
+            eTPU->CHAN[p_uart_instance->tx_chan_num].HSRR.R = ETPU_UART_TX_WAKE_TCR1_HSR;
+        else
+            eTPU->CHAN[p_uart_instance->tx_chan_num].HSRR.R = ETPU_UART_TX_WAKE_TCR2_HSR;
+    }
+}
+
+/* get the index of the lowest set bit of a non-zero mask (count trailing zeros) */
+static uint32_t etpu_uart_ctz32(
+    uint32_t                mask)
+{
+    static const uint8_t debruijn_bit_index[32] =
+    {
+         0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+        31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+    };
+
+    return debruijn_bit_index[((mask & (0 - mask)) * 0x077CB531u) >> 27];
+}
+
+/* get the number of contiguous words that can be pushed onto / popped from a host ring */
+static int32_t etpu_uart_ring_push_size(
+    struct uart_ring_t *p_ring)
+{
+    uint32_t push_index = p_ring->push_index;
+    uint32_t pop_index = p_ring->pop_index;
+
+    if (push_index >= pop_index)
+        return (int32_t)(p_ring->word_size - push_index - (pop_index == 0 ? 1 : 0));
+    return (int32_t)(pop_index - push_index - 1); /* ring full == size - 1 */
+}
+
+static int32_t etpu_uart_ring_pop_size(
+    struct uart_ring_t *p_ring)
+{
+    uint32_t push_index = p_ring->push_index;
+    uint32_t pop_index = p_ring->pop_index;
+
+    if (push_index >= pop_index)
+        return (int32_t)(push_index - pop_index);
+    return (int32_t)(p_ring->word_size - pop_index);
+}
+
+/* split a run of FIFO entries into up to 2 contiguous spans (up to the end, then from the start) */
+static int32_t etpu_uart_fifo_spans(
+    void                   *p_fifo_buffer,
+    int32_t                 fifo_size,
+    uint32_t                entry_size,
+    int32_t                 index,
+    int32_t                 cnt,
+    struct uart_fifo_span_t *p_spans)
+{
+    int32_t first_cnt = fifo_size - index;
+
+    if (first_cnt > cnt)
+        first_cnt = cnt;
+    p_spans[0].p_data = (uint8_t*)p_fifo_buffer + index * entry_size;
+    p_spans[0].word_cnt = first_cnt;
+    p_spans[1].p_data = p_fifo_buffer;
+    p_spans[1].word_cnt = cnt - first_cnt;
+    return cnt;
+}
+
+
+/* get the frequency of the timebase used by the UART */
+static uint32_t etpu_uart_timer_freq(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config)
+{
     if (p_uart_instance->em == EM_AB)
     {
-        eTPU = eTPU_AB;
         if (p_uart_config->timer == FS_ETPU_TCR1)
         {
             if (p_uart_instance->rx_chan_num < 32 || p_uart_instance->tx_chan_num < 32)
             {
-                timer_freq = etpu_a_tcr1_freq;
+                return etpu_a_tcr1_freq;
             }
             else
             {
-                timer_freq = etpu_b_tcr1_freq;
+                return etpu_b_tcr1_freq;
             }
         }
         else
         {
             if (p_uart_instance->rx_chan_num < 32 || p_uart_instance->tx_chan_num < 32)
             {
-                timer_freq = etpu_a_tcr2_freq;
+                return etpu_a_tcr2_freq;
             }
             else
             {
-                timer_freq = etpu_b_tcr2_freq;
+                return etpu_b_tcr2_freq;
             }
         }
     }
     else
     {
-        eTPU = eTPU_C;
         if (p_uart_config->timer == FS_ETPU_TCR1)
         {
-            timer_freq = etpu_c_tcr1_freq;
+            return etpu_c_tcr1_freq;
         }
         else
         {
-            timer_freq = etpu_c_tcr2_freq;
+            return etpu_c_tcr2_freq;
         }
     }
+}
+
+/* set the delays that are multiples of the bit time (stop, TX enable post delay, RX idle timeout, frame gap) */
+static int32_t etpu_uart_set_bit_time_delays(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t                bit_time,
+    uint32_t                bit_time_frac)
+{
+    uint32_t char_half_bit_count, idle_timeout, frame_gap, timer_freq_khz;
+
+    /* idle timeout in character times (start, data, parity and stop bits) */
+    char_half_bit_count = 2 * (1 + p_uart_config->bit_count) + p_uart_config->stop_time_half_bit_count;
+    if (p_uart_config->parity_select < ETPU_UART_PARITY_NONE)
+        char_half_bit_count += 2;
+    /* the idle timeout must fit in 23 bits; the factors are bounded by 
+       division, so that no product can wrap */
+    idle_timeout = 0;
+    if (p_uart_config->rx_idle_timeout_char_count != 0 && bit_time != 0)
+    {
+        if (char_half_bit_count > 0xffffff / bit_time ||
+            p_uart_config->rx_idle_timeout_char_count > 0xffffff / (bit_time * char_half_bit_count))
+            return FS_ETPU_ERROR_VALUE;
+        idle_timeout = bit_time * char_half_bit_count * p_uart_config->rx_idle_timeout_char_count / 2;
+    }
+    /* frame gap, 3.5 character times unless specified; bounded the same way,
+       whole milliseconds and the remainder converted apart */
+    if (p_uart_config->frame_gap_us != 0)
+    {
+        timer_freq_khz = etpu_uart_timer_freq(p_uart_instance, p_uart_config) / 1000;
+        if (timer_freq_khz != 0 && p_uart_config->frame_gap_us / 1000 > 0x7fffff / timer_freq_khz)
+            return FS_ETPU_ERROR_VALUE;
+        frame_gap = timer_freq_khz * (p_uart_config->frame_gap_us / 1000) + 
+            timer_freq_khz * (p_uart_config->frame_gap_us % 1000) / 1000;
+    }
+    else
+    {
+        if (bit_time != 0 && char_half_bit_count > ((0x7fffff * 4 + 3) / 7) / bit_time)
+            return FS_ETPU_ERROR_VALUE;
+        frame_gap = bit_time * char_half_bit_count * 7 / 4;
+    }
+    if (frame_gap > 0x7fffff)
+        return FS_ETPU_ERROR_VALUE;
+
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_stop_time = 
+        bit_time * p_uart_config->stop_time_half_bit_count / 2 + ((bit_time_frac * p_uart_config->stop_time_half_bit_count) >> 9);
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_enable_post_delay = 
+        bit_time * p_uart_config->tx_enable_half_bit_count / 2 + ((bit_time_frac * p_uart_config->tx_enable_half_bit_count) >> 9);
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_idle_timeout = idle_timeout;
+    if (p_uart_instance->frame_block != 0)
+        p_uart_instance->frame_block->frame_gap = frame_gap;
+    return 0;
+}
+
+
+int32_t etpu_uart_init(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config)
+{
+    volatile struct eTPU_struct * eTPU;
+    uint32_t timer_freq;
+    uint8_t init_chan_num = 0xff;
+    uint32_t bit_time, bit_time_frac, timer_cnt;
+    uint32_t rx_entry_size, tx_entry_size;
+    uint32_t data_ram_start, data_ram_ext;
+    uint32_t rx_options, rts_halt_threshold, rts_resume_threshold;
+    uint32_t address_bits;
+
+    eTPU = etpu_uart_engine(p_uart_instance->em);
+    if (p_uart_instance->em == EM_AB)
+    {
+        data_ram_start = fs_etpu_data_ram_start;
+        data_ram_ext = fs_etpu_data_ram_ext;
+    }
+    else
+    {
+        data_ram_start = fs_etpu_c_data_ram_start;
+        data_ram_ext = fs_etpu_c_data_ram_ext;
+    }
+    timer_freq = etpu_uart_timer_freq(p_uart_instance, p_uart_config);
+
+    /* packed RX/TX FIFOs hold one character per byte */
+    if ((p_uart_config->rx_options & ETPU_UART_RX_OPTION_PACKED_FIFO) && p_uart_config->bit_count > 8)
+        return FS_ETPU_ERROR_VALUE;
+    if ((p_uart_config->tx_options & ETPU_UART_TX_OPTION_PACKED_FIFO) && p_uart_config->bit_count > 8)
+        return FS_ETPU_ERROR_VALUE;
+    /* RX frame mode interrupts per frame, and needs room for 1 queued frame at least */
+    if ((p_uart_config->rx_options & ETPU_UART_RX_OPTION_FRAME) && 
+        (p_uart_config->rx_frame_queue_size < 2 || (p_uart_config->rx_options & ETPU_UART_RX_OPTION_DMA) ||
+         p_uart_config->rx_coalesce_latency_us != 0))
+        return FS_ETPU_ERROR_VALUE;
+    /* CRC mode works on 8-bit characters */
+    if (((p_uart_config->rx_options & ETPU_UART_RX_OPTION_CRC) || (p_uart_config->tx_options & ETPU_UART_TX_OPTION_CRC)) &&
+        (p_uart_config->bit_count != 8 || p_uart_config->crc_polynomial == 0 || p_uart_config->crc_polynomial > 0xffff))
+        return FS_ETPU_ERROR_VALUE;
+    /* the eTPU moving the RX FIFO pop would upset DMA blocks and queued frames; the RTS stall needs RTS */
+    if (p_uart_config->rx_overrun_policy > ETPU_UART_RX_OVERRUN_RTS_STALL)
+        return FS_ETPU_ERROR_VALUE;
+    if (p_uart_config->rx_overrun_policy == ETPU_UART_RX_OVERRUN_OVERWRITE_OLDEST &&
+        (p_uart_config->rx_options & (ETPU_UART_RX_OPTION_DMA | ETPU_UART_RX_OPTION_FRAME)))
+        return FS_ETPU_ERROR_VALUE;
+    if (p_uart_config->rx_overrun_policy == ETPU_UART_RX_OVERRUN_RTS_STALL && 
+        (p_uart_instance->rts_chan_num == 0xff || p_uart_config->rx_fifo_word_size < 3 || p_uart_config->rts_halt_threshold == 0))
+        return FS_ETPU_ERROR_VALUE;
+    /* multidrop needs an address mark bit besides the address/data bits */
+    if ((p_uart_config->rx_options & ETPU_UART_RX_OPTION_MULTIDROP) && p_uart_config->bit_count < 2)
+        return FS_ETPU_ERROR_VALUE;
+    /* RX timestamps are stored with each data word */
+    if ((p_uart_config->rx_options & ETPU_UART_RX_OPTION_TIMESTAMP) && (p_uart_config->rx_options & ETPU_UART_RX_OPTION_PACKED_FIFO))
+        return FS_ETPU_ERROR_VALUE;
+    /* edge decode keeps data and parity bits in the 24-bit shift register */
+    if ((p_uart_config->rx_options & ETPU_UART_RX_OPTION_EDGE_DECODE) && 
+        p_uart_config->bit_count + (p_uart_config->parity_select < ETPU_UART_PARITY_NONE ? 1 : 0) > 23)
+        return FS_ETPU_ERROR_VALUE;
+    /* auto-baud times the falling edges of a 0x55 sync character */
+    if ((p_uart_config->rx_options & ETPU_UART_RX_OPTION_AUTO_BAUD) && p_uart_config->bit_count < 8)
+        return FS_ETPU_ERROR_VALUE;
+    /* RX interrupt coalescing needs a word count, and is not used with DMA */
+    if (p_uart_config->rx_coalesce_latency_us != 0 && 
+        (p_uart_config->rx_coalesce_word_count == 0 || (p_uart_config->rx_options & ETPU_UART_RX_OPTION_DMA)))
+        return FS_ETPU_ERROR_VALUE;
+    /* TX DMA mode moves blocks of at least one word */
+    if ((p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA) && p_uart_config->tx_dma_block_word_size == 0)
+        return FS_ETPU_ERROR_VALUE;
+    /* timed entries are full words, and are not looked for in DMA-filled FIFOs */
+    if ((p_uart_config->tx_options & ETPU_UART_TX_OPTION_TIMED) && 
+        (p_uart_config->tx_options & (ETPU_UART_TX_OPTION_PACKED_FIFO | ETPU_UART_TX_OPTION_DMA)))
+        return FS_ETPU_ERROR_VALUE;
+    /* TX DMA blocks are picked up by the TX check, which must keep running */
+    if ((p_uart_config->tx_options & ETPU_UART_TX_OPTION_IDLE_PARK) && (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA))
+        return FS_ETPU_ERROR_VALUE;
+    /* optional host rings need storage for at least one word (ring full == size - 1) */
+    if (p_uart_instance->rx_ring != 0)
+    {
+        if (p_uart_instance->rx_ring->p_buffer == 0 || p_uart_instance->rx_ring->word_size < 2)
+            return FS_ETPU_ERROR_VALUE;
+        p_uart_instance->rx_ring->push_index = 0;
+        p_uart_instance->rx_ring->pop_index = 0;
+    }
+    if (p_uart_instance->tx_ring != 0)
+    {
+        if (p_uart_instance->tx_ring->p_buffer == 0 || p_uart_instance->tx_ring->word_size < 2)
+            return FS_ETPU_ERROR_VALUE;
+        p_uart_instance->tx_ring->push_index = 0;
+        p_uart_instance->tx_ring->pop_index = 0;
+    }
+    rx_entry_size = etpu_uart_rx_entry_size(p_uart_config);
+    tx_entry_size = etpu_uart_tx_entry_size(p_uart_config);
 
     /* first disable channels */
     if (p_uart_instance->rx_chan_num != 0xff)
@@ -84,7 +453,7 @@ int32_t etpu_uart_init(
     {
         /* get parameter RAM for channel frame */
         p_uart_instance->cpba = fs_etpu_malloc_ext(p_uart_instance->em, _FRAME_SIZE_UART_);
-        p_uart_instance->cpba_pse = (void*)((uint32_t)p_uart_instance->cpba + (fs_etpu_data_ram_ext - fs_etpu_data_ram_start));
+        p_uart_instance->cpba_pse = (void*)((uint32_t)p_uart_instance->cpba + (data_ram_ext - data_ram_start));
 
         if (p_uart_instance->cpba  == 0)
         {
@@ -94,16 +463,54 @@ int32_t etpu_uart_init(
         /* allocate RX and TX FIFOs */
         if (p_uart_config->rx_fifo_word_size > 0)
         {
-            p_uart_instance->rx_fifo_buffer = fs_etpu_malloc_ext(p_uart_instance->em, p_uart_config->rx_fifo_word_size * 4);
+            p_uart_instance->rx_fifo_buffer = fs_etpu_malloc_ext(p_uart_instance->em, etpu_uart_rx_fifo_alloc_size(p_uart_config));
             if (p_uart_instance->rx_fifo_buffer == 0)
                 return FS_ETPU_ERROR_MALLOC;
         }
+        if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_DMA)
+        {
+            p_uart_instance->rx_dma_block = (struct uart_dma_block_t*)fs_etpu_malloc_ext(p_uart_instance->em, sizeof(struct uart_dma_block_t));
+            if (p_uart_instance->rx_dma_block == 0)
+                return FS_ETPU_ERROR_MALLOC;
+        }
+        if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_FRAME)
+        {
+            p_uart_instance->rx_frame_queue = fs_etpu_malloc_ext(p_uart_instance->em, p_uart_config->rx_frame_queue_size * 8);
+            if (p_uart_instance->rx_frame_queue == 0)
+                return FS_ETPU_ERROR_MALLOC;
+        }
+        if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA)
+        {
+            p_uart_instance->tx_dma_block = (struct uart_tx_dma_block_t*)fs_etpu_malloc_ext(p_uart_instance->em, sizeof(struct uart_tx_dma_block_t));
+            if (p_uart_instance->tx_dma_block == 0)
+                return FS_ETPU_ERROR_MALLOC;
+        }
         if (p_uart_config->tx_fifo_word_size > 0)
         {
-            p_uart_instance->tx_fifo_buffer = fs_etpu_malloc_ext(p_uart_instance->em, p_uart_config->tx_fifo_word_size * 4);
+            p_uart_instance->tx_fifo_buffer = fs_etpu_malloc_ext(p_uart_instance->em, p_uart_config->tx_fifo_word_size * tx_entry_size);
             if (p_uart_instance->tx_fifo_buffer == 0)
                 return FS_ETPU_ERROR_MALLOC;
         }
+        /* optional feature blocks */
+        if ((p_uart_config->rx_options & (ETPU_UART_RX_OPTION_FRAME | ETPU_UART_RX_OPTION_CRC)) ||
+            (p_uart_config->tx_options & (ETPU_UART_TX_OPTION_FRAME | ETPU_UART_TX_OPTION_CRC)))
+        {
+            p_uart_instance->frame_block = (struct uart_frame_block_t*)fs_etpu_malloc_ext(p_uart_instance->em, sizeof(struct uart_frame_block_t));
+            if (p_uart_instance->frame_block == 0)
+                return FS_ETPU_ERROR_MALLOC;
+        }
+        if (p_uart_config->statistics_enable != 0)
+        {
+            p_uart_instance->stat_block = (struct uart_stat_block_t*)fs_etpu_malloc_ext(p_uart_instance->em, sizeof(struct uart_stat_block_t));
+            if (p_uart_instance->stat_block == 0)
+                return FS_ETPU_ERROR_MALLOC;
+        }
+        if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_AUTO_BAUD)
+        {
+            p_uart_instance->autobaud_block = (struct uart_autobaud_block_t*)fs_etpu_malloc_ext(p_uart_instance->em, sizeof(struct uart_autobaud_block_t));
+            if (p_uart_instance->autobaud_block == 0)
+                return FS_ETPU_ERROR_MALLOC;
+        }
     }
     else  /* set cpba to what is in the CR register */
     {
@@ -114,27 +521,108 @@ int32_t etpu_uart_init(
 
     /* intialize channel frame */
     fs_memset32_ext(p_uart_instance->cpba, 0, _FRAME_SIZE_UART_);
+    if (p_uart_instance->frame_block != 0)
+    {
+        fs_memset32_ext((uint32_t*)p_uart_instance->frame_block, 0, sizeof(struct uart_frame_block_t));
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_frame_block_p = (uint32_t)p_uart_instance->frame_block & 0x3fff;
+    }
+    if (p_uart_instance->stat_block != 0)
+    {
+        fs_memset32_ext((uint32_t*)p_uart_instance->stat_block, 0, sizeof(struct uart_stat_block_t));
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_stat_block_p = (uint32_t)p_uart_instance->stat_block & 0x3fff;
+    }
+    if (p_uart_instance->autobaud_block != 0)
+    {
+        fs_memset32_ext((uint32_t*)p_uart_instance->autobaud_block, 0, sizeof(struct uart_autobaud_block_t));
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_autobaud_block_p = (uint32_t)p_uart_instance->autobaud_block & 0x3fff;
+    }
     ((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_bit_count = p_uart_config->bit_count;
     ((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_parity_select = p_uart_config->parity_select;
     ((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_cts_chan_num = p_uart_instance->cts_chan_num;
     ((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_rts_chan_num = p_uart_instance->rts_chan_num;
     ((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_tx_enable_chan_num = p_uart_instance->txe_chan_num;
+    /* bit time in timer counts, with a fractional part in 1/256 counts */
     bit_time = timer_freq / p_uart_config->baud_rate_hz;
+    bit_time_frac = ((timer_freq % p_uart_config->baud_rate_hz) * 256 + p_uart_config->baud_rate_hz / 2) / p_uart_config->baud_rate_hz;
+    if (bit_time_frac > 0xff)
+    {
+        bit_time++;
+        bit_time_frac = 0;
+    }
+    /* report the resulting baud rate error, timer_cnt being the timer counts of baud_rate_hz bits */
+    timer_cnt = bit_time * p_uart_config->baud_rate_hz + ((bit_time_frac * p_uart_config->baud_rate_hz) >> 8);
+    p_uart_config->baud_rate_error_ppm = ((int32_t)timer_freq - (int32_t)timer_cnt) * 15625 / (int32_t)(timer_cnt >> 6);
     ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_bit_time = bit_time;
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_stop_time = bit_time * p_uart_config->stop_time_half_bit_count / 2;
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_enable_post_delay = bit_time * p_uart_config->tx_enable_half_bit_count / 2;
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_byte_size = p_uart_config->rx_fifo_word_size * 4;
+    ((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_bit_time_frac = bit_time_frac;
+    if (etpu_uart_set_bit_time_delays(p_uart_instance, p_uart_config, bit_time, bit_time_frac) != 0)
+        return FS_ETPU_ERROR_VALUE;
+    timer_cnt = (timer_freq / 1000) * p_uart_config->rx_coalesce_latency_us / 1000;
+    if (timer_cnt > 0x7fffff)
+        return FS_ETPU_ERROR_VALUE;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_coalesce_timeout = timer_cnt;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_coalesce_count = p_uart_config->rx_coalesce_word_count;
+    rx_options = p_uart_config->rx_options;
+    if (p_uart_config->rx_overrun_policy == ETPU_UART_RX_OVERRUN_OVERWRITE_OLDEST)
+        rx_options |= ETPU_UART_RX_OPTION_OVERWRITE;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_options = rx_options;
+    if (p_uart_instance->frame_block != 0)
+    {
+        p_uart_instance->frame_block->crc_poly = p_uart_config->crc_polynomial;
+        p_uart_instance->frame_block->crc_init = p_uart_config->crc_init & 0xffff;
+    }
+    if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_MULTIDROP)
+    {
+        address_bits = (1UL << (p_uart_config->bit_count - 1)) - 1; /* all but the address mark */
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_station_address = p_uart_config->station_address & address_bits;
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_station_mask = p_uart_config->station_address_mask & address_bits;
+    }
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_byte_size = p_uart_config->rx_fifo_word_size * rx_entry_size;
     ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p = (uint32_t)p_uart_instance->rx_fifo_buffer & 0x3fff;
     ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_end_p = 
-        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p + p_uart_config->rx_fifo_word_size * 4;
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_byte_size = p_uart_config->tx_fifo_word_size * 4;
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p + p_uart_config->rx_fifo_word_size * rx_entry_size;
+    if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_PACKED_FIFO)
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_error_map_p = (uint32_t)etpu_uart_rx_error_map(p_uart_instance, p_uart_config) & 0x3fff;
+    if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_FRAME)
+    {
+        p_uart_instance->frame_block->rx_frame_queue_start = (uint32_t)p_uart_instance->rx_frame_queue & 0x3fff;
+        p_uart_instance->frame_block->rx_frame_queue_end = 
+            ((uint32_t)p_uart_instance->rx_frame_queue & 0x3fff) + p_uart_config->rx_frame_queue_size * 8;
+    }
+    if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_DMA)
+    {
+        /* the eTPU fills in the low 24 bits of the block address */
+        p_uart_instance->rx_dma_block->sys_addr = data_ram_start & 0xff000000;
+        p_uart_instance->rx_dma_block->byte_size = 0;
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_dma_sys_base = data_ram_start & 0xffffff;
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_dma_block_p = (uint32_t)p_uart_instance->rx_dma_block & 0x3fff;
+    }
+    if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA)
+    {
+        p_uart_instance->tx_dma_block->dst_addr = data_ram_start & 0xff000000;
+        p_uart_instance->tx_dma_block->src_addr = 0;
+        p_uart_instance->tx_dma_block->byte_size = 0;
+        p_uart_instance->tx_async_callback = 0;
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_dma_sys_base = data_ram_start & 0xffffff;
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_dma_block_p = (uint32_t)p_uart_instance->tx_dma_block & 0x3fff;
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_dma_block_byte_size = p_uart_config->tx_dma_block_word_size * tx_entry_size;
+    }
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_options = p_uart_config->tx_options;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_byte_size = p_uart_config->tx_fifo_word_size * tx_entry_size;
     ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p = (uint32_t)p_uart_instance->tx_fifo_buffer & 0x3fff;
     ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_end_p = 
-        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p + p_uart_config->tx_fifo_word_size * 4;
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_fifo_int_threshold = p_uart_config->rx_fifo_interrupt_threshold * 4;
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_fifo_int_threshold = p_uart_config->tx_fifo_interrupt_threshold * 4;
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_rts_halt_threshold = p_uart_config->rts_halt_threshold * 4;
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_rts_resume_threshold = p_uart_config->rts_resume_threshold * 4;
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p + p_uart_config->tx_fifo_word_size * tx_entry_size;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_fifo_int_threshold = p_uart_config->rx_fifo_interrupt_threshold * rx_entry_size;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_fifo_int_threshold = p_uart_config->tx_fifo_interrupt_threshold * tx_entry_size;
+    /* RTS stall: halt one word before the FIFO is full (size - 1 words) at the latest */
+    rts_halt_threshold = p_uart_config->rts_halt_threshold;
+    if (p_uart_config->rx_overrun_policy == ETPU_UART_RX_OVERRUN_RTS_STALL && rts_halt_threshold > p_uart_config->rx_fifo_word_size - 2)
+        rts_halt_threshold = p_uart_config->rx_fifo_word_size - 2;
+    /* keep resume below halt, or RTS would toggle on every word */
+    rts_resume_threshold = p_uart_config->rts_resume_threshold;
+    if (p_uart_config->rx_overrun_policy == ETPU_UART_RX_OVERRUN_RTS_STALL && rts_resume_threshold >= rts_halt_threshold)
+        rts_resume_threshold = rts_halt_threshold - 1;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_rts_halt_threshold = rts_halt_threshold * rx_entry_size;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_rts_resume_threshold = rts_resume_threshold * rx_entry_size;
 
     /* function mode */
     if (p_uart_config->parity_select < ETPU_UART_PARITY_NONE)
@@ -168,6 +656,22 @@ int32_t etpu_uart_init(
             eTPU->CHAN[p_uart_instance->tx_chan_num].HSRR.R = ETPU_UART_TX_INIT_TCR2_HSR;
     }
 
+    /* RX/TX DMA modes request DMA transfers rather than interrupts */
+    if (p_uart_instance->rx_chan_num != 0xff)
+    {
+        if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_DMA)
+            fs_etpu_dma_enable_ext(p_uart_instance->em, p_uart_instance->rx_chan_num);
+        else
+            fs_etpu_dma_disable_ext(p_uart_instance->em, p_uart_instance->rx_chan_num);
+    }
+    if (p_uart_instance->tx_chan_num != 0xff)
+    {
+        if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA)
+            fs_etpu_dma_enable_ext(p_uart_instance->em, p_uart_instance->tx_chan_num);
+        else
+            fs_etpu_dma_disable_ext(p_uart_instance->em, p_uart_instance->tx_chan_num);
+    }
+
     /* final channel configuration */
     /* CTS, RTS, TXE channels have same base address if enabled */
     if (p_uart_instance->cts_chan_num != 0xff)
@@ -204,8 +708,36 @@ int32_t etpu_uart_transmit_data(
     int32_t i;
     int32_t pop_index, push_index;
     int32_t words_used, words_available, words_written;
-    uint32_t* push_addr, *end_addr;
     
+    /* in TX DMA mode the DMA owns the TX FIFO push side */
+    if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA)
+        return 0;
+    if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_PACKED_FIFO)
+    {
+        /* packed FIFO, one character per byte */
+        uint8_t *tx_chars = (uint8_t*)p_uart_instance->tx_fifo_buffer;
+
+        pop_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_pop_p - 
+            ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p);
+        push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p - 
+            ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p);
+        words_used = push_index - pop_index;
+        if (words_used < 0)
+            words_used = p_uart_config->tx_fifo_word_size + words_used;
+        words_available = p_uart_config->tx_fifo_word_size - words_used - 1; /* FIFO full == size - 1 */
+        words_written = (data_request_cnt < words_available) ? data_request_cnt : words_available;
+        for (i = 0 ; i < words_written; i++)
+        {
+            tx_chars[push_index] = (uint8_t)p_data_buffer[i];
+            if (++push_index == (int32_t)p_uart_config->tx_fifo_word_size)
+                push_index = 0;
+        }
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p = (uint32_t)(tx_chars + push_index) & 0x3fff;
+        if (words_written > 0)
+            etpu_uart_tx_wake(p_uart_instance, p_uart_config);
+        return words_written;
+    }
+
     pop_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_pop_p - 
         ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p) >> 2;
     push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p - 
@@ -215,20 +747,193 @@ int32_t etpu_uart_transmit_data(
         words_used = p_uart_config->tx_fifo_word_size + words_used;
     words_available = p_uart_config->tx_fifo_word_size - words_used - 1; /* FIFO full == size - 1 */
     words_written = (data_request_cnt < words_available) ? data_request_cnt : words_available;
+    if (words_written < 0)
+        words_written = 0;
+    /* push data onto FIFO, in up to 2 contiguous segments (up to the end, then from the start) */
+    i = p_uart_config->tx_fifo_word_size - push_index;
+    if (i > words_written)
+        i = words_written;
+    etpu_uart_copy32((uint32_t*)p_uart_instance->tx_fifo_buffer + push_index, p_data_buffer, i);
+    etpu_uart_copy32((uint32_t*)p_uart_instance->tx_fifo_buffer, p_data_buffer + i, words_written - i);
+    push_index += words_written;
+    if (push_index >= (int32_t)p_uart_config->tx_fifo_word_size)
+        push_index -= p_uart_config->tx_fifo_word_size;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p = 
+        (uint32_t)((uint32_t*)p_uart_instance->tx_fifo_buffer + push_index) & 0x3fff;
+    if (words_written > 0)
+        etpu_uart_tx_wake(p_uart_instance, p_uart_config);
+
+    return words_written;
+}
+
+int32_t etpu_uart_transmit_bytes(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    const uint8_t          *p_data_buffer,
+    int32_t                 data_request_cnt)
+{
+    int32_t i;
+    int32_t pop_index, push_index;
+    int32_t words_used, words_available, words_written;
+    int32_t fifo_size = (int32_t)p_uart_config->tx_fifo_word_size;
+    uint32_t tx_entry_size = etpu_uart_tx_entry_size(p_uart_config);
+    uint8_t *tx_entries = (uint8_t*)p_uart_instance->tx_fifo_buffer;
+
+    if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA)
+        return 0;
+    pop_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_pop_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p) / tx_entry_size;
+    push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p) / tx_entry_size;
+    words_used = push_index - pop_index;
+    if (words_used < 0)
+        words_used = fifo_size + words_used;
+    words_available = fifo_size - words_used - 1; /* FIFO full == size - 1 */
+    words_written = (data_request_cnt < words_available) ? data_request_cnt : words_available;
     /* push data onto FIFO */
-    push_addr = (uint32_t*)p_uart_instance->tx_fifo_buffer + push_index;
-    end_addr = (uint32_t*)p_uart_instance->tx_fifo_buffer + p_uart_config->tx_fifo_word_size;
-    for (i = 0 ; i < words_written; i++)
+    i = 0;
+    while (i < words_written)
     {
-        *push_addr++ = p_data_buffer[i];
-        if (push_addr == end_addr)
-            push_addr = (uint32_t*)p_uart_instance->tx_fifo_buffer;
+        if (tx_entry_size == 1 && (push_index & 3) == 0 && words_written - i >= 4 && push_index + 4 <= fifo_size)
+        {
+            /* 4 free characters in one aligned word, write them at once (data RAM is big-endian) */
+            *(uint32_t*)(tx_entries + push_index) = 
+                ((uint32_t)p_data_buffer[i] << 24) | ((uint32_t)p_data_buffer[i + 1] << 16) | 
+                ((uint32_t)p_data_buffer[i + 2] << 8) | (uint32_t)p_data_buffer[i + 3];
+            i += 4;
+            push_index += 4;
+        }
+        else
+        {
+            if (tx_entry_size == 1)
+                tx_entries[push_index] = p_data_buffer[i];
+            else
+                *(uint32_t*)(tx_entries + push_index * 4) = p_data_buffer[i];
+            i++;
+            push_index++;
+        }
+        if (push_index == fifo_size)
+            push_index = 0;
     }
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p = (uint32_t)push_addr & 0x3fff;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p = (uint32_t)(tx_entries + push_index * tx_entry_size) & 0x3fff;
+    if (words_written > 0)
+        etpu_uart_tx_wake(p_uart_instance, p_uart_config);
 
     return words_written;
 }
 
+int32_t etpu_uart_transmit_data_at(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t                start_time,
+    uint32_t               *p_data_buffer,
+    int32_t                 data_request_cnt)
+{
+    uint32_t *tx_words = (uint32_t*)p_uart_instance->tx_fifo_buffer;
+    int32_t i;
+    int32_t pop_index, push_index;
+    int32_t words_used, words_available;
+
+    if ((p_uart_config->tx_options & (ETPU_UART_TX_OPTION_TIMED | ETPU_UART_TX_OPTION_DMA)) != ETPU_UART_TX_OPTION_TIMED || 
+        data_request_cnt <= 0)
+        return 0;
+    pop_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_pop_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p) >> 2;
+    push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p) >> 2;
+    words_used = push_index - pop_index;
+    if (words_used < 0)
+        words_used = p_uart_config->tx_fifo_word_size + words_used;
+    words_available = p_uart_config->tx_fifo_word_size - words_used - 1; /* FIFO full == size - 1 */
+    if (data_request_cnt + 1 > words_available)
+        return 0;
+    /* timed entry, then the block, all made visible to the eTPU with one push update */
+    tx_words[push_index] = ETPU_UART_TX_START_TIME | (start_time & 0xffffff);
+    if (++push_index == (int32_t)p_uart_config->tx_fifo_word_size)
+        push_index = 0;
+    for (i = 0; i < data_request_cnt; i++)
+    {
+        tx_words[push_index] = p_data_buffer[i] & ~ETPU_UART_TX_START_TIME;
+        if (++push_index == (int32_t)p_uart_config->tx_fifo_word_size)
+            push_index = 0;
+    }
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p = 
+        (uint32_t)(tx_words + push_index) & 0x3fff;
+    etpu_uart_tx_wake(p_uart_instance, p_uart_config);
+
+    return data_request_cnt;
+}
+
+int32_t etpu_uart_transmit_addressed(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t                address,
+    uint32_t               *p_data_buffer,
+    int32_t                 data_request_cnt)
+{
+    uint32_t address_mark, address_word;
+    int32_t fifo_size, fifo_used;
+
+    if ((p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA) || p_uart_config->bit_count < 2 || data_request_cnt < 0)
+        return 0;
+    /* all or nothing, so that the data cannot go out under another address */
+    etpu_uart_transmit_fifo_status(p_uart_instance, p_uart_config, &fifo_size, &fifo_used);
+    if (data_request_cnt + 1 > fifo_size - fifo_used - 1) /* FIFO full == size - 1 */
+        return 0;
+    address_mark = 1UL << (p_uart_config->bit_count - 1);
+    address_word = address_mark | (address & (address_mark - 1));
+    etpu_uart_transmit_data(p_uart_instance, p_uart_config, &address_word, 1);
+    return etpu_uart_transmit_data(p_uart_instance, p_uart_config, p_data_buffer, data_request_cnt);
+}
+
+int32_t etpu_uart_transmit_data_async(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    const void             *p_data_buffer,
+    int32_t                 data_request_cnt,
+    void                  (*p_callback)(struct uart_instance_t *p_uart_instance))
+{
+    uint32_t src_addr = (uint32_t)p_data_buffer;
+    uint32_t byte_cnt = data_request_cnt * etpu_uart_tx_entry_size(p_uart_config);
+
+    if ((p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA) == 0 || data_request_cnt <= 0)
+        return FS_ETPU_ERROR_VALUE;
+    /* the remaining size is a signed 24-bit count on the eTPU */
+    if ((uint32_t)data_request_cnt > 0x7fffff / etpu_uart_tx_entry_size(p_uart_config))
+        return FS_ETPU_ERROR_VALUE;
+    /* the eTPU only tracks the low 24 bits of the source address */
+    if ((src_addr & 0xff000000) != ((src_addr + byte_cnt - 1) & 0xff000000))
+        return FS_ETPU_ERROR_VALUE;
+    if (((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_dma_remaining_size != 0)
+        return FS_ETPU_ERROR_VALUE;
+
+    p_uart_instance->tx_async_callback = p_callback;
+    p_uart_instance->tx_dma_block->src_addr = src_addr & 0xff000000;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_dma_src_addr = src_addr & 0xffffff;
+    /* writing the size last starts the transfer */
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_dma_remaining_size = byte_cnt;
+
+    return 0;
+}
+
+int32_t etpu_uart_transmit_async_complete(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config)
+{
+    void (*p_callback)(struct uart_instance_t *p_uart_instance);
+
+    if ((p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA) == 0)
+        return 0;
+    if (((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_dma_remaining_size != 0)
+        return 0;
+    p_callback = p_uart_instance->tx_async_callback;
+    p_uart_instance->tx_async_callback = 0;
+    if (p_callback != 0)
+        p_callback(p_uart_instance);
+
+    return 1;
+}
+
 int32_t etpu_uart_receive_data(
     struct uart_instance_t *p_uart_instance,
     struct uart_config_t   *p_uart_config,
@@ -236,45 +941,579 @@ int32_t etpu_uart_receive_data(
     int32_t                 data_buffer_size,
     uint32_t               *p_overrun_error_status)
 {
-    volatile struct eTPU_struct * eTPU;
-    int32_t read_cnt = 0;
+    int32_t read_cnt = 0, segment_cnt;
     int32_t pop_index, push_index;
-    uint32_t *push_addr, *pop_addr, *end_addr;
+    uint32_t old_pop_p;
 
-    if (p_uart_instance->em == EM_AB)
-        eTPU = eTPU_AB;
-    else
-        eTPU = eTPU_C;
+    if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_PACKED_FIFO)
+    {
+        /* unpack characters and their error flags into the word format */
+        uint8_t *rx_chars = (uint8_t*)p_uart_instance->rx_fifo_buffer;
+        uint8_t *error_map = etpu_uart_rx_error_map(p_uart_instance, p_uart_config);
 
-    pop_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_pop_p - 
-        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) >> 2;
-    push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p - 
-        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) >> 2;
-    pop_addr = (uint32_t*)p_uart_instance->rx_fifo_buffer + pop_index;
-    push_addr = (uint32_t*)p_uart_instance->rx_fifo_buffer + push_index;
-    end_addr = (uint32_t*)p_uart_instance->rx_fifo_buffer + p_uart_config->rx_fifo_word_size;
-    /* pop data from FIFO */
-    while (pop_addr != push_addr && read_cnt < data_buffer_size)
-    {
-        p_data_buffer[read_cnt++].rx_data_word = *pop_addr++;
-        if (pop_addr == end_addr)
-            pop_addr = (uint32_t*)p_uart_instance->rx_fifo_buffer;
-    }
-    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_pop_p = (uint32_t)pop_addr & 0x3fff;
-    if (p_uart_instance->rx_chan_num != 0xff)
-        eTPU->CHAN[p_uart_instance->rx_chan_num].HSRR.R = ETPU_UART_RX_UPDATE_RTS_HSR;
-    
-    /* get overrun error status if requested (clear if read) */
-    if (p_overrun_error_status != 0)
+        do
+        {
+            read_cnt = 0;
+            old_pop_p = etpu_uart_rx_pop_p(p_uart_instance);
+            pop_index = (int32_t)(old_pop_p - ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p);
+            push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p - 
+                ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p);
+            while (pop_index != push_index && read_cnt < data_buffer_size)
+            {
+                p_data_buffer[read_cnt++].rx_data_word = 
+                    ((uint32_t)((error_map[pop_index >> 2] >> ((pop_index & 3) << 1)) & 0x3) << 24) | rx_chars[pop_index];
+                if (++pop_index == (int32_t)p_uart_config->rx_fifo_word_size)
+                    pop_index = 0;
+            }
+        } while (etpu_uart_rx_update_pop(p_uart_instance, old_pop_p, rx_chars + pop_index, p_overrun_error_status) != 0);
+        return read_cnt;
+    }
+    if (p_uart_config->rx_options & ETPU_UART_RX_OPTION_TIMESTAMP)
     {
-        *p_overrun_error_status = (uint32_t)((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_overrun_error;
-        if (*p_overrun_error_status != 0)
-            ((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_overrun_error = 0; /* clear it */
+        /* skip the start bit time that follows each data word */
+        uint32_t *rx_words = (uint32_t*)p_uart_instance->rx_fifo_buffer;
+
+        do
+        {
+            read_cnt = 0;
+            old_pop_p = etpu_uart_rx_pop_p(p_uart_instance);
+            pop_index = (int32_t)(old_pop_p - ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) >> 3;
+            push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p - 
+                ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) >> 3;
+            while (pop_index != push_index && read_cnt < data_buffer_size)
+            {
+                p_data_buffer[read_cnt++].rx_data_word = rx_words[pop_index * 2];
+                if (++pop_index == (int32_t)p_uart_config->rx_fifo_word_size)
+                    pop_index = 0;
+            }
+        } while (etpu_uart_rx_update_pop(p_uart_instance, old_pop_p, rx_words + pop_index * 2, p_overrun_error_status) != 0);
+        return read_cnt;
     }
+
+    do
+    {
+        old_pop_p = etpu_uart_rx_pop_p(p_uart_instance);
+        pop_index = (int32_t)(old_pop_p - ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) >> 2;
+        push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p - 
+            ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) >> 2;
+        /* pop data from FIFO, in up to 2 contiguous segments (up to the push or end, then from the start) */
+        if (push_index >= pop_index)
+        {
+            segment_cnt = push_index - pop_index;
+            read_cnt = segment_cnt;
+        }
+        else
+        {
+            segment_cnt = p_uart_config->rx_fifo_word_size - pop_index;
+            read_cnt = segment_cnt + push_index;
+        }
+        if (read_cnt > data_buffer_size)
+            read_cnt = (data_buffer_size > 0) ? data_buffer_size : 0;
+        if (segment_cnt > read_cnt)
+            segment_cnt = read_cnt;
+        etpu_uart_copy32(&p_data_buffer[0].rx_data_word, (uint32_t*)p_uart_instance->rx_fifo_buffer + pop_index, segment_cnt);
+        etpu_uart_copy32(&p_data_buffer[segment_cnt].rx_data_word, (uint32_t*)p_uart_instance->rx_fifo_buffer, read_cnt - segment_cnt);
+        pop_index += read_cnt;
+        if (pop_index >= (int32_t)p_uart_config->rx_fifo_word_size)
+            pop_index -= p_uart_config->rx_fifo_word_size;
+    } while (etpu_uart_rx_update_pop(p_uart_instance, old_pop_p, (uint32_t*)p_uart_instance->rx_fifo_buffer + pop_index, p_overrun_error_status) != 0);
+    
+    return read_cnt;
+}
+
+int32_t etpu_uart_receive_timed_data(
+    struct uart_instance_t      *p_uart_instance,
+    struct uart_config_t        *p_uart_config,
+    struct uart_rx_timed_data_t *p_data_buffer,
+    int32_t                      data_buffer_size,
+    uint32_t                    *p_overrun_error_status)
+{
+    int32_t read_cnt, segment_cnt;
+    int32_t pop_index, push_index;
+    uint32_t old_pop_p;
+
+    if ((p_uart_config->rx_options & ETPU_UART_RX_OPTION_TIMESTAMP) == 0)
+        return 0;
+    do
+    {
+        old_pop_p = etpu_uart_rx_pop_p(p_uart_instance);
+        pop_index = (int32_t)(old_pop_p - ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) >> 3;
+        push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p - 
+            ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) >> 3;
+        /* the FIFO entries have the record layout, copy in up to 2 contiguous segments */
+        if (push_index >= pop_index)
+        {
+            segment_cnt = push_index - pop_index;
+            read_cnt = segment_cnt;
+        }
+        else
+        {
+            segment_cnt = p_uart_config->rx_fifo_word_size - pop_index;
+            read_cnt = segment_cnt + push_index;
+        }
+        if (read_cnt > data_buffer_size)
+            read_cnt = (data_buffer_size > 0) ? data_buffer_size : 0;
+        if (segment_cnt > read_cnt)
+            segment_cnt = read_cnt;
+        etpu_uart_copy32((uint32_t*)&p_data_buffer[0], (uint32_t*)p_uart_instance->rx_fifo_buffer + pop_index * 2, segment_cnt * 2);
+        etpu_uart_copy32((uint32_t*)&p_data_buffer[segment_cnt], (uint32_t*)p_uart_instance->rx_fifo_buffer, (read_cnt - segment_cnt) * 2);
+        pop_index += read_cnt;
+        if (pop_index >= (int32_t)p_uart_config->rx_fifo_word_size)
+            pop_index -= p_uart_config->rx_fifo_word_size;
+    } while (etpu_uart_rx_update_pop(p_uart_instance, old_pop_p, (uint32_t*)p_uart_instance->rx_fifo_buffer + pop_index * 2, p_overrun_error_status) != 0);
     
     return read_cnt;
 }
 
+int32_t etpu_uart_receive_frame(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t               *p_start_index,
+    uint32_t               *p_length,
+    uint32_t               *p_error_flags)
+{
+    volatile struct uart_frame_block_t *frame_block = p_uart_instance->frame_block;
+    uint32_t pop_p;
+    uint32_t *frame_entry;
+
+    if (frame_block == 0)
+        return 0;
+    pop_p = frame_block->rx_frame_queue_pop;
+    if (pop_p == frame_block->rx_frame_queue_push)
+        return 0;
+    /* entry: error flags in MSB and FIFO byte offset in LSBs, then the length */
+    frame_entry = (uint32_t*)((uint8_t*)p_uart_instance->rx_frame_queue + (pop_p - ((uint32_t)p_uart_instance->rx_frame_queue & 0x3fff)));
+    if (p_start_index != 0)
+        *p_start_index = (frame_entry[0] & 0xffffff) / etpu_uart_rx_entry_size(p_uart_config);
+    if (p_length != 0)
+        *p_length = frame_entry[1] & 0xffffff;
+    if (p_error_flags != 0)
+        *p_error_flags = frame_entry[0] >> 24;
+    pop_p += 8;
+    if (pop_p == frame_block->rx_frame_queue_end)
+        pop_p = frame_block->rx_frame_queue_start;
+    frame_block->rx_frame_queue_pop = pop_p;
+    return 1;
+}
+
+int32_t etpu_uart_crc_status(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t               *p_rx_crc,
+    uint32_t               *p_tx_crc)
+{
+    if (p_uart_instance->frame_block == 0)
+        return FS_ETPU_ERROR_VALUE;
+    if (p_rx_crc != 0)
+        *p_rx_crc = p_uart_instance->frame_block->rx_crc & 0xffff;
+    if (p_tx_crc != 0)
+        *p_tx_crc = p_uart_instance->frame_block->tx_crc & 0xffff;
+    return 0;
+}
+
+int32_t etpu_uart_crc_reset(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t                reset_rx,
+    uint32_t                reset_tx)
+{
+    if (p_uart_instance->frame_block == 0)
+        return FS_ETPU_ERROR_VALUE;
+    if (reset_rx != 0)
+        p_uart_instance->frame_block->rx_crc = p_uart_config->crc_init & 0xffff;
+    if (reset_tx != 0)
+        p_uart_instance->frame_block->tx_crc = p_uart_config->crc_init & 0xffff;
+    return 0;
+}
+
+int32_t etpu_uart_receive_bytes(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint8_t                *p_data_buffer,
+    uint8_t                *p_error_buffer,
+    int32_t                 data_buffer_size,
+    uint32_t               *p_overrun_error_status)
+{
+    int32_t read_cnt;
+    int32_t pop_index, push_index;
+    uint32_t old_pop_p;
+    uint32_t rx_entry_size = etpu_uart_rx_entry_size(p_uart_config);
+    uint8_t *rx_entries = (uint8_t*)p_uart_instance->rx_fifo_buffer;
+    uint8_t *error_map = etpu_uart_rx_error_map(p_uart_instance, p_uart_config);
+
+    do
+    {
+        read_cnt = 0;
+        old_pop_p = etpu_uart_rx_pop_p(p_uart_instance);
+        pop_index = (int32_t)(old_pop_p - ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) / rx_entry_size;
+        push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p - 
+            ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) / rx_entry_size;
+        /* pop data from FIFO */
+        while (pop_index != push_index && read_cnt < data_buffer_size)
+        {
+            if (rx_entry_size == 1)
+            {
+                p_data_buffer[read_cnt] = rx_entries[pop_index];
+                if (p_error_buffer != 0)
+                    p_error_buffer[read_cnt] = (error_map[pop_index >> 2] >> ((pop_index & 3) << 1)) & 0x3;
+            }
+            else
+            {
+                /* word format, flags in MSB, data in LSB */
+                p_data_buffer[read_cnt] = rx_entries[pop_index * rx_entry_size + 3];
+                if (p_error_buffer != 0)
+                    p_error_buffer[read_cnt] = rx_entries[pop_index * rx_entry_size];
+            }
+            read_cnt++;
+            if (++pop_index == (int32_t)p_uart_config->rx_fifo_word_size)
+                pop_index = 0;
+        }
+    } while (etpu_uart_rx_update_pop(p_uart_instance, old_pop_p, rx_entries + pop_index * rx_entry_size, p_overrun_error_status) != 0);
+
+    return read_cnt;
+}
+
+int32_t etpu_uart_rx_dma_commit(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config)
+{
+    int32_t pop_offset;
+    int32_t byte_size = (int32_t)p_uart_instance->rx_dma_block->byte_size;
+    int32_t word_cnt;
+    uint32_t old_pop_p;
+
+    if (byte_size == 0)
+        return 0;
+    old_pop_p = etpu_uart_rx_pop_p(p_uart_instance);
+    pop_offset = (int32_t)(old_pop_p - ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) + byte_size;
+    if (pop_offset == (int32_t)(p_uart_config->rx_fifo_word_size * etpu_uart_rx_entry_size(p_uart_config)))
+        pop_offset = 0;
+    /* pop must move before the block is released, the eTPU publishes the next block from it */
+    etpu_uart_rx_update_pop(p_uart_instance, old_pop_p, (uint8_t*)p_uart_instance->rx_fifo_buffer + pop_offset, 0);
+    p_uart_instance->rx_dma_block->byte_size = 0;
+
+    word_cnt = byte_size / etpu_uart_rx_entry_size(p_uart_config);
+    if (p_uart_instance->rx_dma_callback != 0)
+        p_uart_instance->rx_dma_callback(p_uart_instance, word_cnt);
+    return word_cnt;
+}
+
+int32_t etpu_uart_rx_peek(
+    struct uart_instance_t  *p_uart_instance,
+    struct uart_config_t    *p_uart_config,
+    struct uart_fifo_span_t *p_spans)
+{
+    uint32_t rx_entry_size = etpu_uart_rx_entry_size(p_uart_config);
+    int32_t fifo_size = (int32_t)p_uart_config->rx_fifo_word_size;
+    int32_t pop_index, push_index, words_used;
+
+    pop_index = (int32_t)(etpu_uart_rx_pop_p(p_uart_instance) - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) / rx_entry_size;
+    push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) / rx_entry_size;
+    words_used = push_index - pop_index;
+    if (words_used < 0)
+        words_used += fifo_size;
+    return etpu_uart_fifo_spans(p_uart_instance->rx_fifo_buffer, fifo_size, rx_entry_size, pop_index, words_used, p_spans);
+}
+
+int32_t etpu_uart_rx_commit(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    int32_t                 word_cnt,
+    uint32_t               *p_overrun_error_status)
+{
+    uint32_t rx_entry_size = etpu_uart_rx_entry_size(p_uart_config);
+    int32_t fifo_size = (int32_t)p_uart_config->rx_fifo_word_size;
+    int32_t pop_index, push_index, words_used, words_left, words_dropped;
+    uint32_t old_pop_p, pop_p;
+
+    old_pop_p = etpu_uart_rx_pop_p(p_uart_instance);
+    pop_index = (int32_t)(old_pop_p - ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) / rx_entry_size;
+    push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_start_p) / rx_entry_size;
+    words_used = push_index - pop_index;
+    if (words_used < 0)
+        words_used += fifo_size;
+    if (word_cnt > words_used)
+        word_cnt = words_used;
+    if (word_cnt <= 0)
+    {
+        /* pop does not move, no need to have the eTPU re-evaluate RTS */
+        etpu_uart_rx_overrun_status(p_uart_instance, p_overrun_error_status);
+        return 0;
+    }
+    pop_index += word_cnt;
+    if (pop_index >= fifo_size)
+        pop_index -= fifo_size;
+    words_left = word_cnt;
+    while (etpu_uart_rx_update_pop(p_uart_instance, old_pop_p, (uint8_t*)p_uart_instance->rx_fifo_buffer + pop_index * rx_entry_size, p_overrun_error_status) != 0)
+    {
+        /* overwrite-oldest policy: the eTPU has dropped words meanwhile, the committed words
+           may have been overwritten (reported as overrun), pop only moves if still behind */
+        pop_p = etpu_uart_rx_pop_p(p_uart_instance);
+        words_dropped = (int32_t)(pop_p - old_pop_p) / (int32_t)rx_entry_size;
+        if (words_dropped < 0)
+            words_dropped += fifo_size;
+        if (words_dropped >= words_left)
+        {
+            etpu_uart_rx_overrun_status(p_uart_instance, p_overrun_error_status);
+            break;
+        }
+        words_left -= words_dropped;
+        old_pop_p = pop_p;
+    }
+    return word_cnt;
+}
+
+int32_t etpu_uart_tx_reserve(
+    struct uart_instance_t  *p_uart_instance,
+    struct uart_config_t    *p_uart_config,
+    struct uart_fifo_span_t *p_spans)
+{
+    uint32_t tx_entry_size = etpu_uart_tx_entry_size(p_uart_config);
+    int32_t fifo_size = (int32_t)p_uart_config->tx_fifo_word_size;
+    int32_t pop_index, push_index, words_used;
+
+    pop_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_pop_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p) / tx_entry_size;
+    push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p) / tx_entry_size;
+    words_used = push_index - pop_index;
+    if (words_used < 0)
+        words_used += fifo_size;
+    if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA)
+        words_used = fifo_size - 1; /* nothing to reserve, the DMA owns the push side */
+    /* FIFO full == size - 1 */
+    return etpu_uart_fifo_spans(p_uart_instance->tx_fifo_buffer, fifo_size, tx_entry_size, push_index, fifo_size - words_used - 1, p_spans);
+}
+
+int32_t etpu_uart_tx_commit(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    int32_t                 word_cnt)
+{
+    uint32_t tx_entry_size = etpu_uart_tx_entry_size(p_uart_config);
+    int32_t fifo_size = (int32_t)p_uart_config->tx_fifo_word_size;
+    int32_t pop_index, push_index, words_used;
+
+    if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA)
+        return 0;
+    pop_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_pop_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p) / tx_entry_size;
+    push_index = (int32_t)(((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p - 
+        ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_start_p) / tx_entry_size;
+    words_used = push_index - pop_index;
+    if (words_used < 0)
+        words_used += fifo_size;
+    if (word_cnt > fifo_size - words_used - 1)
+        word_cnt = fifo_size - words_used - 1;
+    if (word_cnt <= 0)
+        return 0;
+    push_index += word_cnt;
+    if (push_index >= fifo_size)
+        push_index -= fifo_size;
+    ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p = 
+        (uint32_t)((uint8_t*)p_uart_instance->tx_fifo_buffer + push_index * tx_entry_size) & 0x3fff;
+    etpu_uart_tx_wake(p_uart_instance, p_uart_config);
+    return word_cnt;
+}
+
+int32_t etpu_uart_rx_ring_fill(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t               *p_overrun_error_status)
+{
+    struct uart_ring_t *p_ring = p_uart_instance->rx_ring;
+    int32_t total_cnt = 0, segment_cnt, read_cnt;
+    uint32_t push_index;
+
+    /* spill in up to 2 contiguous segments (up to the end, then from the start) */
+    do
+    {
+        segment_cnt = etpu_uart_ring_push_size(p_ring);
+        push_index = p_ring->push_index;
+        read_cnt = etpu_uart_receive_data(p_uart_instance, p_uart_config, 
+            (union uart_rx_data_t*)(p_ring->p_buffer + push_index), segment_cnt, p_overrun_error_status);
+        push_index += read_cnt;
+        if (push_index == p_ring->word_size)
+            push_index = 0;
+        p_ring->push_index = push_index; /* publish after the data is in place */
+        total_cnt += read_cnt;
+    } while (read_cnt == segment_cnt && push_index == 0 && read_cnt > 0);
+
+    return total_cnt;
+}
+
+int32_t etpu_uart_tx_ring_drain(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config)
+{
+    struct uart_ring_t *p_ring = p_uart_instance->tx_ring;
+    int32_t total_cnt = 0, segment_cnt, written_cnt;
+    uint32_t pop_index;
+
+    if (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA)
+        return 0;
+    /* refill in up to 2 contiguous segments (up to the end, then from the start) */
+    do
+    {
+        segment_cnt = etpu_uart_ring_pop_size(p_ring);
+        pop_index = p_ring->pop_index;
+        written_cnt = etpu_uart_transmit_data(p_uart_instance, p_uart_config, p_ring->p_buffer + pop_index, segment_cnt);
+        pop_index += written_cnt;
+        if (pop_index == p_ring->word_size)
+            pop_index = 0;
+        p_ring->pop_index = pop_index;
+        total_cnt += written_cnt;
+    } while (written_cnt == segment_cnt && pop_index == 0 && written_cnt > 0);
+
+    return total_cnt;
+}
+
+int32_t etpu_uart_ring_read(
+    struct uart_instance_t *p_uart_instance,
+    union uart_rx_data_t   *p_data_buffer,
+    int32_t                 data_buffer_size)
+{
+    struct uart_ring_t *p_ring = p_uart_instance->rx_ring;
+    int32_t read_cnt = 0, segment_cnt;
+    uint32_t pop_index = p_ring->pop_index;
+
+    while (read_cnt < data_buffer_size)
+    {
+        segment_cnt = etpu_uart_ring_pop_size(p_ring);
+        if (segment_cnt == 0)
+            break;
+        if (segment_cnt > data_buffer_size - read_cnt)
+            segment_cnt = data_buffer_size - read_cnt;
+        etpu_uart_copy32(&p_data_buffer[read_cnt].rx_data_word, p_ring->p_buffer + pop_index, segment_cnt);
+        read_cnt += segment_cnt;
+        pop_index += segment_cnt;
+        if (pop_index == p_ring->word_size)
+            pop_index = 0;
+        p_ring->pop_index = pop_index;
+    }
+
+    return read_cnt;
+}
+
+int32_t etpu_uart_ring_write(
+    struct uart_instance_t *p_uart_instance,
+    uint32_t               *p_data_buffer,
+    int32_t                 data_request_cnt)
+{
+    struct uart_ring_t *p_ring = p_uart_instance->tx_ring;
+    int32_t written_cnt = 0, segment_cnt;
+    uint32_t push_index = p_ring->push_index;
+
+    while (written_cnt < data_request_cnt)
+    {
+        segment_cnt = etpu_uart_ring_push_size(p_ring);
+        if (segment_cnt == 0)
+            break;
+        if (segment_cnt > data_request_cnt - written_cnt)
+            segment_cnt = data_request_cnt - written_cnt;
+        etpu_uart_copy32(p_ring->p_buffer + push_index, p_data_buffer + written_cnt, segment_cnt);
+        written_cnt += segment_cnt;
+        push_index += segment_cnt;
+        if (push_index == p_ring->word_size)
+            push_index = 0;
+        p_ring->push_index = push_index;
+    }
+
+    return written_cnt;
+}
+
+int32_t etpu_uart_dispatch_add(
+    struct uart_dispatch_t *p_dispatch,
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config)
+{
+    uint32_t index;
+
+    if (p_uart_instance->em != p_dispatch->em)
+        return FS_ETPU_ERROR_VALUE;
+    /* the default service needs something to fill or drain */
+    if (p_uart_instance->rx_chan_num != 0xff && p_dispatch->rx_handler == 0 && p_uart_instance->rx_ring == 0)
+        return FS_ETPU_ERROR_VALUE;
+    if (p_uart_instance->tx_chan_num != 0xff && p_dispatch->tx_handler == 0 && p_uart_instance->tx_ring == 0 &&
+        (p_uart_config->tx_options & ETPU_UART_TX_OPTION_DMA) == 0)
+        return FS_ETPU_ERROR_VALUE;
+    /* table index 0-31 for engine A (or C) channels, 32-63 for engine B channels */
+    if (p_uart_instance->rx_chan_num != 0xff)
+    {
+        index = (p_uart_instance->rx_chan_num & 0x1f) | ((p_uart_instance->rx_chan_num & 0x40) >> 1);
+        p_dispatch->p_instance[index] = p_uart_instance;
+        p_dispatch->p_config[index] = p_uart_config;
+        p_dispatch->rx_mask[index >> 5] |= 1u << (index & 0x1f);
+    }
+    if (p_uart_instance->tx_chan_num != 0xff)
+    {
+        index = (p_uart_instance->tx_chan_num & 0x1f) | ((p_uart_instance->tx_chan_num & 0x40) >> 1);
+        p_dispatch->p_instance[index] = p_uart_instance;
+        p_dispatch->p_config[index] = p_uart_config;
+        p_dispatch->tx_mask[index >> 5] |= 1u << (index & 0x1f);
+    }
+    return 0;
+}
+
+int32_t etpu_uart_dispatch_interrupts(
+    struct uart_dispatch_t *p_dispatch)
+{
+    volatile struct eTPU_struct * eTPU = etpu_uart_engine(p_dispatch->em);
+    uint32_t cisr[2], pending;
+    uint32_t engine, index;
+    int32_t service_cnt = 0;
+
+    /* read and clear all pending UART channel interrupts in one access per engine, before servicing,
+       so that an interrupt raised while servicing is not lost */
+    cisr[0] = eTPU->CISR_A.R & (p_dispatch->rx_mask[0] | p_dispatch->tx_mask[0]);
+    if (cisr[0] != 0)
+        eTPU->CISR_A.R = cisr[0];
+    cisr[1] = 0;
+    if (p_dispatch->em == EM_AB)
+    {
+        cisr[1] = eTPU->CISR_B.R & (p_dispatch->rx_mask[1] | p_dispatch->tx_mask[1]);
+        if (cisr[1] != 0)
+            eTPU->CISR_B.R = cisr[1];
+    }
+
+    /* service all RX channels first, they are the ones that can overrun */
+    for (engine = 0; engine < 2; engine++)
+    {
+        pending = cisr[engine] & p_dispatch->rx_mask[engine];
+        while (pending != 0)
+        {
+            index = (engine << 5) | etpu_uart_ctz32(pending);
+            pending &= pending - 1;
+            if (p_dispatch->rx_handler != 0)
+                p_dispatch->rx_handler(p_dispatch->p_instance[index], p_dispatch->p_config[index]);
+            else if (p_dispatch->p_instance[index]->rx_ring != 0)
+                etpu_uart_rx_ring_fill(p_dispatch->p_instance[index], p_dispatch->p_config[index], 0);
+            service_cnt++;
+        }
+    }
+    for (engine = 0; engine < 2; engine++)
+    {
+        pending = cisr[engine] & p_dispatch->tx_mask[engine];
+        while (pending != 0)
+        {
+            index = (engine << 5) | etpu_uart_ctz32(pending);
+            pending &= pending - 1;
+            if (p_dispatch->tx_handler != 0)
+                p_dispatch->tx_handler(p_dispatch->p_instance[index], p_dispatch->p_config[index]);
+            else if (p_dispatch->p_config[index]->tx_options & ETPU_UART_TX_OPTION_DMA)
+                etpu_uart_transmit_async_complete(p_dispatch->p_instance[index], p_dispatch->p_config[index]);
+            else if (p_dispatch->p_instance[index]->tx_ring != 0)
+                etpu_uart_tx_ring_drain(p_dispatch->p_instance[index], p_dispatch->p_config[index]);
+            service_cnt++;
+        }
+    }
+
+    return service_cnt;
+}
+
 int32_t etpu_uart_transmit_fifo_status(
     struct uart_instance_t *p_uart_instance,
     struct uart_config_t   *p_uart_config,
@@ -283,8 +1522,8 @@ int32_t etpu_uart_transmit_fifo_status(
 {
     int32_t pop_index, push_index;
     int32_t words_used;
-    pop_index = (int32_t)((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_pop_p >> 2;
-    push_index = (int32_t)((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p >> 2;
+    pop_index = (int32_t)((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_pop_p / etpu_uart_tx_entry_size(p_uart_config);
+    push_index = (int32_t)((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_tx_buffer_push_p / etpu_uart_tx_entry_size(p_uart_config);
     words_used = push_index - pop_index;
     if (words_used < 0)
         words_used = p_uart_config->tx_fifo_word_size + words_used;
@@ -301,8 +1540,8 @@ int32_t etpu_uart_receive_fifo_status(
 {
     int32_t pop_index, push_index;
     int32_t words_used;
-    pop_index = (int32_t)((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_pop_p >> 2;
-    push_index = (int32_t)((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p >> 2;
+    pop_index = (int32_t)etpu_uart_rx_pop_p(p_uart_instance) / etpu_uart_rx_entry_size(p_uart_config);
+    push_index = (int32_t)((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_rx_buffer_push_p / etpu_uart_rx_entry_size(p_uart_config);
     words_used = push_index - pop_index;
     if (words_used < 0)
         words_used = p_uart_config->rx_fifo_word_size + words_used;
@@ -310,3 +1549,62 @@ int32_t etpu_uart_receive_fifo_status(
     if (p_fifo_used != 0) *p_fifo_used = words_used;
     return 0;
 }
+
+int32_t etpu_uart_autobaud_status(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t               *p_baud_rate_hz)
+{
+    uint32_t bit_time, bit_time_frac;
+
+    if (p_uart_instance->autobaud_block == 0 ||
+        (int8_t)(p_uart_instance->autobaud_block->edge_count_start_time >> 24) >= 0)
+        return 0;
+
+    /* the eTPU has measured the bit time, update the dependent delays to match */
+    bit_time = ((etpu_if_UART_CHANNEL_FRAME_PSE*)p_uart_instance->cpba_pse)->_bit_time;
+    bit_time_frac = ((etpu_if_UART_CHANNEL_FRAME*)p_uart_instance->cpba)->_bit_time_frac;
+    p_uart_config->baud_rate_hz = (etpu_uart_timer_freq(p_uart_instance, p_uart_config) << 4) / ((bit_time << 4) + (bit_time_frac >> 4));
+    p_uart_config->baud_rate_error_ppm = 0;
+    etpu_uart_set_bit_time_delays(p_uart_instance, p_uart_config, bit_time, bit_time_frac);
+    if (p_baud_rate_hz != 0)
+        *p_baud_rate_hz = p_uart_config->baud_rate_hz;
+    return 1;
+}
+
+int32_t etpu_uart_statistics_snapshot(
+    struct uart_instance_t   *p_uart_instance,
+    struct uart_config_t     *p_uart_config,
+    struct uart_statistics_t *p_stats)
+{
+    uint8_t chan_num = p_uart_instance->rx_chan_num;
+    int32_t value1, value2;
+    uint32_t err_code = 0;
+    uint32_t offset;
+
+    if (p_uart_instance->stat_block == 0)
+        return FS_ETPU_ERROR_VALUE;
+    if (chan_num == 0xff)
+        chan_num = p_uart_instance->tx_chan_num;
+    /* the CDC takes offsets from the channel frame, the block may be anywhere
+       in the data RAM; each pair shares an 8-byte aligned doubleword of the
+       block, so never straddles a CDC 128-word base */
+    offset = ((uint32_t)p_uart_instance->stat_block & 0x3fff) - ((uint32_t)p_uart_instance->cpba & 0x3fff) + 1;
+    err_code |= fs_etpu_coherent_read_24_ext(p_uart_instance->em, chan_num, 
+        offset, offset + 4, &value1, &value2);
+    p_stats->rx_count = (uint32_t)value1 & 0xffffff;
+    p_stats->rx_overrun_count = (uint32_t)value2 & 0xffffff;
+    err_code |= fs_etpu_coherent_read_24_ext(p_uart_instance->em, chan_num, 
+        offset + 8, offset + 12, &value1, &value2);
+    p_stats->framing_error_count = (uint32_t)value1 & 0xffffff;
+    p_stats->parity_error_count = (uint32_t)value2 & 0xffffff;
+    err_code |= fs_etpu_coherent_read_24_ext(p_uart_instance->em, chan_num, 
+        offset + 16, offset + 20, &value1, &value2);
+    p_stats->tx_count = (uint32_t)value1 & 0xffffff;
+    p_stats->cts_stall_count = (uint32_t)value2 & 0xffffff;
+    err_code |= fs_etpu_coherent_read_24_ext(p_uart_instance->em, chan_num, 
+        offset + 24, offset + 28, &value1, &value2);
+    p_stats->rx_fifo_high_water = ((uint32_t)value1 & 0xffffff) / etpu_uart_rx_entry_size(p_uart_config);
+    p_stats->tx_fifo_high_water = ((uint32_t)value2 & 0xffffff) / etpu_uart_tx_entry_size(p_uart_config);
+    return (int32_t)err_code;
+}
@@ -24,6 +24,15 @@ extern "C" {
 #define ETPU_UART_PARITY_ODD    1
 #define ETPU_UART_PARITY_NONE   2
 
+/* RX overrun policies */
+#define ETPU_UART_RX_OVERRUN_DROP_NEWEST      0
+#define ETPU_UART_RX_OVERRUN_OVERWRITE_OLDEST 1
+#define ETPU_UART_RX_OVERRUN_RTS_STALL        2
+
+/* CRC-16 polynomials, reflected (LSB first) */
+#define ETPU_UART_CRC16_MODBUS  0xA001 /* x^16 + x^15 + x^2 + 1, init 0xFFFF */
+#define ETPU_UART_CRC16_CCITT   0x8408 /* x^16 + x^12 + x^5 + 1 */
+
 /* note: additional macro defintions can be found in the etpu_set_defines.h file */
 
 /* format for a received UART word includes a combination of error flags and data */
@@ -52,11 +61,212 @@ union uart_rx_data_t
 };
 #endif
 
+/* packed RX FIFO (ETPU_UART_RX_OPTION_PACKED_FIFO, word size 8 bits or less):
+   characters are stored one per byte, and their error flags are kept in a
+   separate map of 2 bits per character, 4 characters per map byte (character
+   N uses bits 2*(N%4)+1:2*(N%4) of map byte N/4). */
+
+/* packed TX FIFO (ETPU_UART_TX_OPTION_PACKED_FIFO, word size 8 bits or less):
+   characters are stored one per byte, so etpu_uart_transmit_bytes() can load
+   up to 4 characters with each 32-bit data RAM write. */
+
+/* RX edge decode (ETPU_UART_RX_OPTION_EDGE_DECODE): rather than sampling
+   every bit in the middle of its bit time, the RX channel captures each 
+   transition of a word and rebuilds the bits from the transition times, then
+   checks the stop bit with a single match. A word costs one thread per 
+   transition plus one, e.g. 3 threads for 0x00 or 0xFF instead of 10 for 8
+   data bits, which helps at high baud rates or with many UART channels. 
+   Transition times are rounded to the nearest bit boundary, fractional bit
+   time included, for the same half bit tolerance as sampling mid-bit. Data
+   plus parity bits must not exceed 23. */
+
+/* TX run-length mode (ETPU_UART_TX_OPTION_RUN_LENGTH): the TX channel 
+   schedules one match per level change of the output rather than one per 
+   bit, e.g. 1 thread plus the TX check for 0x00 and 2 for 0xFF instead of 9
+   for 8 data bits, no parity. The data and parity bits are prepared when the
+   word is popped off the TX FIFO. */
+
+/* RX DMA mode (ETPU_UART_RX_OPTION_DMA): instead of interrupting, the RX
+   channel raises a DMA request each time it publishes a contiguous block of
+   received FIFO data in its block descriptor. A block is published once the
+   previous one has been committed and the FIFO holds at least 
+   rx_fifo_interrupt_threshold words, and is at most that size. If the FIFO
+   size is a multiple of the threshold, every block is exactly threshold words
+   and blocks walk the FIFO in order, so a DMA channel with a fixed transfer
+   count and a source address that wraps with the FIFO can service them. The
+   descriptor also suits scatter/gather use, its first word being the block
+   system bus address and its second the block size in bytes. The DMA
+   completion handler must call etpu_uart_rx_dma_commit() to release the 
+   block back to the eTPU. */
+struct uart_dma_block_t
+{
+    uint32_t sys_addr;   /* system bus address of the block */
+    uint32_t byte_size;  /* block size in bytes, 0 if none pending */
+};
+
+/* RX timestamps (ETPU_UART_RX_OPTION_TIMESTAMP, not with the packed RX 
+   FIFO): the RX channel latches the capture time of each start bit falling
+   edge, and stores it in the RX FIFO right after the data word, which
+   doubles the RX FIFO memory. The time is exact to the timer count, unlike a
+   time taken in the interrupt handler. etpu_uart_receive_timed_data() returns
+   both, the other receive routines return the data only. */
+struct uart_rx_timed_data_t
+{
+    union uart_rx_data_t rx_data;
+    uint32_t             start_time; /* timer (TCR1/TCR2) count in the 24 LSBs */
+};
+
+/* frame mode (ETPU_UART_RX_OPTION_FRAME, ETPU_UART_TX_OPTION_FRAME), e.g. for
+   Modbus RTU: frames are delimited by a minimum silence of frame_gap_us, or
+   3.5 character times by default. The RX channel times the gap after each
+   character and, once a frame is complete, queues its position, length and
+   error summary (the OR of the character error flags, plus
+   ETPU_UART_RX_FRAME_OVERRUN_ERROR if characters were dropped) and raises
+   one RX interrupt, instead of the RX FIFO threshold interrupt. The frame is
+   read with etpu_uart_receive_frame(), then its characters with the other
+   receive routines. The TX channel ends a frame when the TX FIFO runs empty,
+   or after a data word flagged with ETPU_UART_TX_END_OF_FRAME (unpacked TX 
+   FIFO only), and holds the next frame until the gap has elapsed. */
+
+/* RX overrun policy (rx_overrun_policy): by default a word received into a
+   full RX FIFO is dropped, keeping the older data (drop-newest). With
+   ETPU_UART_RX_OVERRUN_OVERWRITE_OLDEST, e.g. for telemetry streams, the eTPU
+   drops the oldest word instead (not with RX DMA or frame mode). The RX FIFO
+   pop pointer keeps a single writer, the host: the eTPU marks the end of the
+   words it dropped in a frame field of its own, the receive routines read 
+   from whichever of the two is later, move pop past the dropped words when 
+   they commit, and re-read data the eTPU may have overwritten meanwhile. With ETPU_UART_RX_OVERRUN_RTS_STALL, e.g. for
+   command links, RTS is de-asserted one word before the FIFO is full at the
+   latest, whatever rts_halt_threshold, and rts_resume_threshold is lowered
+   below the halt threshold if needed. Dropped words are reported by the 
+   overrun status either way. */
+
+/* CRC mode (ETPU_UART_RX_OPTION_CRC, ETPU_UART_TX_OPTION_CRC, 8-bit words):
+   the eTPU keeps a running CRC-16 of the characters received and sent, with
+   the crc_polynomial and crc_init of the configuration and no final XOR, so
+   the host does not have to go over the characters again. The TX channel 
+   appends the CRC, low byte first, after a data word flagged with 
+   ETPU_UART_TX_END_OF_FRAME (unpacked TX FIFO only), then restarts it. In RX
+   frame mode the CRC is checked and restarted at the end of each frame, a
+   frame with a bad CRC getting ETPU_UART_RX_CRC_ERROR in its error summary.
+   Otherwise the CRCs are read with etpu_uart_crc_status() and restarted with
+   etpu_uart_crc_reset(). */
+
+/* frame mode and CRC mode state, in a block allocated by etpu_uart_init() 
+   with an RX/TX frame or CRC option only, so that UARTs not using these
+   modes keep a small channel frame. Values are in the 24 LSBs. */
+struct uart_frame_block_t
+{
+    uint32_t frame_gap;
+    uint32_t rx_frame_queue_start; /* eTPU address of the RX frame queue */
+    uint32_t rx_frame_queue_end;
+    uint32_t rx_frame_queue_pop;
+    uint32_t rx_frame_queue_push;
+    uint32_t crc_poly;
+    uint32_t crc_init;
+    uint32_t rx_crc;
+    uint32_t tx_crc;
+    uint32_t state[4];             /* eTPU private */
+};
+
+/* multidrop mode (ETPU_UART_RX_OPTION_MULTIDROP), e.g. for 9-bit RS-485 
+   buses: the MSB of each word is an address mark, the other bit_count - 1
+   bits being an address or data. On an address word, the RX channel compares
+   the address bits selected by station_address_mask to station_address, and
+   keeps the address word and the data words that follow only if they match.
+   Words for other stations are dropped by the eTPU, without any RX FIFO
+   access or interrupt; they are still counted in the statistics. Words 
+   received before the first address word are dropped too. 
+   etpu_uart_transmit_addressed() sends an address word and its data. */
+
+/* statistics (statistics_enable), in a block allocated and cleared by 
+   etpu_uart_init(), read with etpu_uart_statistics_snapshot(). Values are
+   in the 24 LSBs. */
+struct uart_stat_block_t
+{
+    uint32_t rx_count;
+    uint32_t rx_overrun_count;
+    uint32_t framing_error_count;
+    uint32_t parity_error_count;
+    uint32_t tx_count;
+    uint32_t cts_stall_count;
+    uint32_t rx_fifo_high_water;   /* in bytes */
+    uint32_t tx_fifo_high_water;   /* in bytes */
+    uint32_t tx_cts_stalled;       /* eTPU private */
+};
+
+/* auto-baud state (ETPU_UART_RX_OPTION_AUTO_BAUD), in a block allocated by
+   etpu_uart_init(). The edge count, in the MSB of the first word, turns 
+   negative once the bit time has been measured. */
+struct uart_autobaud_block_t
+{
+    uint32_t edge_count_start_time;
+    uint32_t last_time;
+    uint32_t interval;
+};
+
+/* timed TX (ETPU_UART_TX_OPTION_TIMED, unpacked TX FIFO, not with TX DMA): 
+   etpu_uart_transmit_data_at() queues timed entries, words flagged with
+   ETPU_UART_TX_START_TIME in their MSB. Without the option the TX channel
+   ignores the MSB of TX words, as do all other modes. */
+
+/* TX idle park (ETPU_UART_TX_OPTION_IDLE_PARK, not with TX DMA): by default
+   the TX channel checks its TX FIFO once per stop time, even while there is
+   nothing to send. In this mode a TX channel finding its FIFO empty disables
+   its match and parks, taking no eTPU time at all until the host pushes new
+   data. The transmit routines and etpu_uart_tx_commit() then wake it with a
+   host service request, only if the channel is parked, so a busy 
+   transmitter costs no extra HSR. A channel parking while data is being 
+   pushed either sees the push and keeps polling, or is seen parked. */
+
+/* TX DMA mode (ETPU_UART_TX_OPTION_DMA): a whole buffer queued with 
+   etpu_uart_transmit_data_async() is moved into the TX FIFO by DMA, without
+   any interrupt per FIFO refill. Each time the TX FIFO drains to 
+   tx_fifo_interrupt_threshold words or less, the TX channel publishes the next
+   contiguous block (at most tx_dma_block_word_size words) in its block 
+   descriptor and raises a DMA request. The DMA must copy byte_size bytes from
+   src_addr to dst_addr and then write 0 to byte_size, e.g. with one eDMA 
+   channel loading the descriptor into the source/destination/count fields of
+   a linked copy channel, which in turn links to a channel clearing byte_size.
+   The eTPU pushes a filled block onto the FIFO on its next TX check, and 
+   raises the TX channel interrupt once the whole buffer is in the FIFO. The
+   TX channel interrupt handler must then call 
+   etpu_uart_transmit_async_complete(). The regular TX threshold interrupt is
+   not raised in this mode, and the routines that push onto the TX FIFO 
+   directly (transmit_data/bytes/data_at/addressed, tx_reserve/tx_commit,
+   tx_ring_drain) return 0 without touching it. */
+struct uart_tx_dma_block_t
+{
+    uint32_t dst_addr;   /* system bus address of the TX FIFO block */
+    uint32_t src_addr;   /* system bus address of the source data */
+    uint32_t byte_size;  /* block size in bytes, 0 if none pending */
+};
+
 
 /**************************************************************************/
 /*                         Type Definitions                               */
 /**************************************************************************/
 
+/** A contiguous run of entries inside a FIFO buffer, as returned by
+ *  etpu_uart_rx_peek() and etpu_uart_tx_reserve(). */
+struct uart_fifo_span_t
+{
+    void          *p_data;   /* first entry (union uart_rx_data_t/uint32_t words, struct uart_rx_timed_data_t if timestamped, or characters if packed) */
+    int32_t       word_cnt;  /* number of entries, may be 0 */
+};
+
+/** An optional host ring buffer in system RAM, layered over the small eTPU
+ *  RX or TX FIFO. The storage is provided by the application, one word per
+ *  entry (the union uart_rx_data_t format for RX). The indexes are reset by
+ *  etpu_uart_init(). */
+struct uart_ring_t
+{
+    uint32_t      *p_buffer;
+    uint32_t      word_size; /* ring full == size - 1 */
+    volatile uint32_t push_index;
+    volatile uint32_t pop_index;
+};
+
 /** A structure to represent an instance of a UART
  *  It includes static UART initialization items. */
 struct uart_instance_t
@@ -75,6 +285,18 @@ struct uart_instance_t
     void          *cpba_pse;    /* set during initialization */
     void          *rx_fifo_buffer; /* stores address of RX FIFO allocated during initialization */
     void          *tx_fifo_buffer; /* stores address of TX FIFO allocated during initialization */
+    volatile struct uart_dma_block_t *rx_dma_block; /* stores address of RX DMA block descriptor allocated during initialization */
+    /* optional RX DMA completion callback, called by etpu_uart_rx_dma_commit() */
+    void          (*rx_dma_callback)(struct uart_instance_t *p_uart_instance, int32_t word_cnt);
+    volatile struct uart_tx_dma_block_t *tx_dma_block; /* stores address of TX DMA block descriptor allocated during initialization */
+    /* completion callback of the pending etpu_uart_transmit_data_async() request */
+    void          (*tx_async_callback)(struct uart_instance_t *p_uart_instance);
+    struct uart_ring_t *rx_ring; /* optional host RX ring, 0 for none */
+    struct uart_ring_t *tx_ring; /* optional host TX ring, 0 for none */
+    void          *rx_frame_queue; /* stores address of RX frame queue allocated during initialization */
+    volatile struct uart_frame_block_t *frame_block; /* stores address of frame/CRC mode block allocated during initialization */
+    volatile struct uart_stat_block_t *stat_block; /* stores address of statistics block allocated during initialization */
+    volatile struct uart_autobaud_block_t *autobaud_block; /* stores address of auto-baud block allocated during initialization */
 };
 /** A structure to represent a configuration of a UART.
  *  It includes configuration items which can be changed in run-time. */
@@ -85,8 +307,8 @@ struct uart_config_t
     uint8_t       parity_select;
     uint32_t      baud_rate_hz;
     uint32_t      stop_time_half_bit_count; /* specify stop time in number of half bit times */
-    uint32_t      rx_fifo_word_size; /* size in data words to allocate for RX FIFO */
-    uint32_t      tx_fifo_word_size; /* size in data words to allocate for TX FIFO */
+    uint32_t      rx_fifo_word_size; /* size in data words to allocate for RX FIFO (characters if packed) */
+    uint32_t      tx_fifo_word_size; /* size in data words to allocate for TX FIFO (characters if packed) */
     uint32_t      rx_fifo_interrupt_threshold; /* when RX FIFO this full or fuller, interrupt on each new word received */
     uint32_t      tx_fifo_interrupt_threshold; /* when TX FIFO this empty, or emptier, interrupt on each word transmit */
     
@@ -96,6 +318,55 @@ struct uart_config_t
     
     /* RS-485 TX enable */
     uint32_t      tx_enable_half_bit_count; /* post TX delay of TX enable output de-assert, in count of half bit times */
+
+    /* optional features */
+    uint32_t      rx_options; /* ETPU_UART_RX_OPTION_* flags, 0 for none */
+    uint32_t      tx_options; /* ETPU_UART_TX_OPTION_* flags, 0 for none */
+    uint32_t      tx_dma_block_word_size; /* TX DMA mode maximum block size in data words (characters if packed) */
+    uint32_t      rx_idle_timeout_char_count; /* interrupt when RX line idle this many character times with FIFO data pending, 0 to disable */
+    uint32_t      rx_coalesce_latency_us; /* coalescing, replaces the RX FIFO threshold interrupt: interrupt at most this long after a word is received (up to a character time more while words keep arriving), 0 to disable */
+    uint32_t      rx_coalesce_word_count; /* coalescing: or once this many words have been received since the last interrupt */
+    uint32_t      rx_frame_queue_size; /* RX frame mode: number of complete frames the eTPU can queue */
+    uint32_t      frame_gap_us; /* frame mode: minimum silence between frames, 0 for 3.5 character times */
+    uint32_t      crc_polynomial; /* CRC mode: ETPU_UART_CRC16_MODBUS or ETPU_UART_CRC16_CCITT */
+    uint32_t      crc_init; /* CRC mode: CRC start value, e.g. 0xFFFF for Modbus */
+    uint32_t      rx_overrun_policy; /* ETPU_UART_RX_OVERRUN_*, 0 to drop the newest word */
+    uint32_t      station_address; /* multidrop: address of this station, without the address mark bit */
+    uint32_t      station_address_mask; /* multidrop: address bits compared, 0 to accept all addresses */
+    uint32_t      statistics_enable; /* 1 to keep statistics, 0 to save the eTPU time and memory */
+
+    /* set by etpu_uart_init */
+    int32_t       baud_rate_error_ppm; /* achieved baud rate error in parts per million, positive if faster than baud_rate_hz */
+};
+/** A channel to UART lookup for servicing the interrupts of many UARTs on
+ *  one eTPU engine from a single interrupt handler. Set em and the optional
+ *  handlers, zero the rest, then register each UART with 
+ *  etpu_uart_dispatch_add(). */
+struct uart_dispatch_t
+{
+    ETPU_MODULE   em;
+    /* optional RX/TX service routines, 0 to fill/drain the instance host rings (TX DMA: complete the async transmission) */
+    void          (*rx_handler)(struct uart_instance_t *p_uart_instance, struct uart_config_t *p_uart_config);
+    void          (*tx_handler)(struct uart_instance_t *p_uart_instance, struct uart_config_t *p_uart_config);
+    /* set by etpu_uart_dispatch_add(), [0] for engine A (or C), [1] for engine B */
+    uint32_t      rx_mask[2];
+    uint32_t      tx_mask[2];
+    struct uart_instance_t *p_instance[64];
+    struct uart_config_t   *p_config[64];
+};
+
+/** A snapshot of the statistics kept by the eTPU since initialization, as
+ *  read by etpu_uart_statistics_snapshot(). The counts wrap at 0xFFFFFF. */
+struct uart_statistics_t
+{
+    uint32_t      rx_count;              /* characters received */
+    uint32_t      rx_overrun_count;      /* characters dropped for lack of RX FIFO room */
+    uint32_t      framing_error_count;
+    uint32_t      parity_error_count;
+    uint32_t      tx_count;              /* characters transmitted */
+    uint32_t      cts_stall_count;       /* times TX was held by CTS with data waiting */
+    uint32_t      rx_fifo_high_water;    /* most RX FIFO data words used (characters if packed) */
+    uint32_t      tx_fifo_high_water;    /* most TX FIFO data words used, as seen by the eTPU */
 };
 
 
@@ -132,7 +403,7 @@ int32_t etpu_uart_init(
  * data_request_cnt - the requested number of data words to transfer (not
  * all may actually get pushed into TX FIFO if it runs out of room).
  *
- * Returns the number of data words pushed onto TX FIFO.
+ * Returns the number of data words pushed onto TX FIFO, 0 in TX DMA mode.
  **************************************************************************/
 int32_t etpu_uart_transmit_data(
     struct uart_instance_t *p_uart_instance,
@@ -140,6 +411,136 @@ int32_t etpu_uart_transmit_data(
     uint32_t               *p_data_buffer,
     int32_t                 data_request_cnt);
 
+/**************************************************************************
+ * etpu_uart_transmit_bytes() - this routine requests a data transfer for up 
+ * to the specified number of characters from a byte buffer. With the packed
+ * TX FIFO option, aligned groups of 4 characters are written to the TX FIFO
+ * with a single 32-bit access.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_data_buffer - pointer to the buffer of characters to be transmitted.
+ *
+ * data_request_cnt - the requested number of characters to transfer (not
+ * all may actually get pushed into TX FIFO if it runs out of room).
+ *
+ * Returns the number of characters pushed onto TX FIFO, 0 in TX DMA mode.
+ **************************************************************************/
+int32_t etpu_uart_transmit_bytes(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    const uint8_t          *p_data_buffer,
+    int32_t                 data_request_cnt);
+
+/**************************************************************************
+ * etpu_uart_transmit_data_at() - this routine queues a block of data words
+ * to be transmitted back to back from an absolute time, e.g. for a TDMA slot.
+ * The block is preceded in the TX FIFO by a timed entry 
+ * (ETPU_UART_TX_START_TIME | start time), on which the TX channel keeps the
+ * line idle until the start bit of the first word is due. The words already
+ * in the TX FIFO are sent first, and CTS, when enabled, may still hold the
+ * block. ETPU_UART_TX_OPTION_TIMED mode only. ETPU_UART_TX_START_TIME is
+ * cleared in the data words.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * start_time - time of the start bit of the first word, in counts of the 
+ * UART timer (TCR1 or TCR2, 24 bits). It must be at least one stop time
+ * ahead once the preceding words are sent.
+ *
+ * p_data_buffer - pointer to the buffer of data to be transmitted.
+ *
+ * data_request_cnt - the number of data words in the block.
+ *
+ * Returns the number of data words pushed onto TX FIFO: all of them, or 0
+ * if the TX FIFO does not have room for the whole block and its timed entry,
+ * not in timed mode or in TX DMA mode.
+ **************************************************************************/
+int32_t etpu_uart_transmit_data_at(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t                start_time,
+    uint32_t               *p_data_buffer,
+    int32_t                 data_request_cnt);
+
+/**************************************************************************
+ * etpu_uart_transmit_addressed() - this routine queues an address word, 
+ * with the address mark (MSB of the bit_count bits) set, followed by a block
+ * of data words, for a multidrop bus (see ETPU_UART_RX_OPTION_MULTIDROP). 
+ * The data words are sent as they are, their address mark should be clear.
+ * Not in TX DMA mode.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * address - address of the station(s) to send the data to, in the 
+ * bit_count - 1 LSBs.
+ *
+ * p_data_buffer - pointer to the buffer of data to be transmitted.
+ *
+ * data_request_cnt - the number of data words in the block, may be 0.
+ *
+ * Returns the number of data words pushed onto TX FIFO: all of them, or 0
+ * if the TX FIFO does not have room for the whole block and its address word.
+ **************************************************************************/
+int32_t etpu_uart_transmit_addressed(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t                address,
+    uint32_t               *p_data_buffer,
+    int32_t                 data_request_cnt);
+
+/**************************************************************************
+ * etpu_uart_transmit_data_async() - this routine queues a whole buffer for 
+ * transmission in TX DMA mode. The buffer is moved into the TX FIFO by DMA
+ * as the FIFO drains, and the callback is called from 
+ * etpu_uart_transmit_async_complete() once it has all been loaded, after
+ * which the buffer may be reused.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_data_buffer - pointer to the data to be transmitted, in the TX FIFO 
+ * entry format (32-bit data words, or characters if packed). It must not
+ * cross a 16MB boundary of the system bus address space.
+ *
+ * data_request_cnt - the number of data words to transmit.
+ *
+ * p_callback - function to call on completion, or 0/NULL if not wanted.
+ *
+ * Returns failure code (FS_ETPU_ERROR_VALUE if not in TX DMA mode, the 
+ * buffer exceeds 0x7FFFFF bytes or a previous request is still pending), 
+ * or pass (0).
+ **************************************************************************/
+int32_t etpu_uart_transmit_data_async(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    const void             *p_data_buffer,
+    int32_t                 data_request_cnt,
+    void                  (*p_callback)(struct uart_instance_t *p_uart_instance));
+
+/**************************************************************************
+ * etpu_uart_transmit_async_complete() - this routine is to be called from 
+ * the TX channel interrupt handler in TX DMA mode. If the pending 
+ * etpu_uart_transmit_data_async() request has completed, its callback is
+ * called.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * Returns 1 if the request completed, otherwise 0.
+ **************************************************************************/
+int32_t etpu_uart_transmit_async_complete(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config);
+
 /**************************************************************************
  * etpu_uart_receive_data() - this routine requests to read data from the RX
  * FIFO, up to a specified number of words.
@@ -166,6 +567,345 @@ int32_t etpu_uart_receive_data(
     int32_t                 data_buffer_size,
     uint32_t               *p_overrun_error_status);
 
+/**************************************************************************
+ * etpu_uart_receive_timed_data() - this routine reads received data words
+ * along with their start bit times, in timestamp mode 
+ * (ETPU_UART_RX_OPTION_TIMESTAMP).
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_data_buffer - pointer to where to copy the timestamped data words.
+ *
+ * data_buffer_size - the maximum number of data words to read.
+ *
+ * p_overrun_error_status - pointer to where to write the overrun error status.
+ * Ignored if 0/NULL.
+ *
+ * Returns the number of data words read, 0 if not in timestamp mode.
+ **************************************************************************/
+int32_t etpu_uart_receive_timed_data(
+    struct uart_instance_t      *p_uart_instance,
+    struct uart_config_t        *p_uart_config,
+    struct uart_rx_timed_data_t *p_data_buffer,
+    int32_t                      data_buffer_size,
+    uint32_t                    *p_overrun_error_status);
+
+/**************************************************************************
+ * etpu_uart_receive_frame() - this routine gets the next complete frame
+ * received in RX frame mode (ETPU_UART_RX_OPTION_FRAME). The frame 
+ * characters are next in the RX FIFO once the previous frames have been read.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_start_index - pointer to where to write the RX FIFO index of the first 
+ * character. Ignored if 0/NULL.
+ *
+ * p_length - pointer to where to write the number of characters.
+ * Ignored if 0/NULL.
+ *
+ * p_error_flags - pointer to where to write the frame error summary.
+ * Ignored if 0/NULL.
+ *
+ * Returns 1 if a frame was read, 0 if none is complete.
+ **************************************************************************/
+int32_t etpu_uart_receive_frame(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t               *p_start_index,
+    uint32_t               *p_length,
+    uint32_t               *p_error_flags);
+
+/**************************************************************************
+ * etpu_uart_crc_status() - this routine reads the running CRC-16 values of
+ * the characters received and transmitted in CRC mode 
+ * (ETPU_UART_RX_OPTION_CRC, ETPU_UART_TX_OPTION_CRC).
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_rx_crc - pointer to where to write the RX CRC, or 0/NULL if not wanted.
+ *
+ * p_tx_crc - pointer to where to write the TX CRC, or 0/NULL if not wanted.
+ *
+ * Returns failure code (no CRC or frame mode), or pass (0).
+ **************************************************************************/
+int32_t etpu_uart_crc_status(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t               *p_rx_crc,
+    uint32_t               *p_tx_crc);
+
+/**************************************************************************
+ * etpu_uart_crc_reset() - this routine restarts the running RX and/or TX
+ * CRC-16 from crc_init, e.g. at the start of a frame. It must be called 
+ * between characters, i.e. while the line is idle for RX, and while the TX
+ * FIFO is empty for TX.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * reset_rx - non-zero to restart the RX CRC.
+ *
+ * reset_tx - non-zero to restart the TX CRC.
+ *
+ * Returns failure code (no CRC or frame mode), or pass (0).
+ **************************************************************************/
+int32_t etpu_uart_crc_reset(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t                reset_rx,
+    uint32_t                reset_tx);
+
+/**************************************************************************
+ * etpu_uart_receive_bytes() - this routine requests to read characters from
+ * the RX FIFO, up to a specified number, into a byte buffer. It is intended
+ * for use with the packed RX FIFO option, where it avoids any unpacking into
+ * 32-bit words.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_data_buffer - pointer to the buffer into which to place characters 
+ * popped off the RX FIFO.
+ *
+ * p_error_buffer - pointer to a buffer into which to place the error flags
+ * (ETPU_UART_RX_FRAMING_ERROR, ETPU_UART_RX_PARITY_ERROR) of each character.
+ * Ignored if 0/NULL.
+ *
+ * data_buffer_size - the maximum number of characters to be read.
+ *
+ * p_overrun_error_status - pointer to where to write the overrun error status.
+ * Ignored if 0/NULL.
+ *
+ * Returns the actual number of characters read from the RX FIFO.
+ **************************************************************************/
+int32_t etpu_uart_receive_bytes(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint8_t                *p_data_buffer,
+    uint8_t                *p_error_buffer,
+    int32_t                 data_buffer_size,
+    uint32_t               *p_overrun_error_status);
+
+/**************************************************************************
+ * etpu_uart_rx_dma_commit() - this routine releases the RX DMA block that
+ * was just transferred, by advancing the RX FIFO pop pointer past it and
+ * clearing the block descriptor, so that the eTPU can publish the next block.
+ * It is to be called from the DMA transfer completion handler, and calls the
+ * instance rx_dma_callback, if any, once the block is released.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * Returns the number of data words released, 0 if no block was pending.
+ **************************************************************************/
+int32_t etpu_uart_rx_dma_commit(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config);
+
+/**************************************************************************
+ * etpu_uart_rx_peek() - this routine gives direct access to the unread data
+ * in the RX FIFO, without copying it. The data is returned as up to 2 
+ * contiguous spans in FIFO order (the second one is used when the data wraps
+ * around the end of the FIFO). It stays in the FIFO until released with 
+ * etpu_uart_rx_commit(). With the packed RX FIFO option the spans hold the
+ * characters only, their error flags are available with 
+ * etpu_uart_receive_bytes().
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_spans - pointer to an array of 2 spans to fill in.
+ *
+ * Returns the total number of data words available in the spans.
+ **************************************************************************/
+int32_t etpu_uart_rx_peek(
+    struct uart_instance_t  *p_uart_instance,
+    struct uart_config_t    *p_uart_config,
+    struct uart_fifo_span_t *p_spans);
+
+/**************************************************************************
+ * etpu_uart_rx_commit() - this routine releases data words obtained with
+ * etpu_uart_rx_peek() back to the RX FIFO. The eTPU is only asked to 
+ * re-evaluate the RTS output when the pop position actually moves.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * word_cnt - the number of data words consumed, from the start of the 
+ * first span.
+ *
+ * p_overrun_error_status - pointer to where to write the overrun error status.
+ * Ignored if 0/NULL.
+ *
+ * Returns the number of data words released.
+ **************************************************************************/
+int32_t etpu_uart_rx_commit(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    int32_t                 word_cnt,
+    uint32_t               *p_overrun_error_status);
+
+/**************************************************************************
+ * etpu_uart_tx_reserve() - this routine gives direct access to the free
+ * space in the TX FIFO, so that data can be formatted in place. The space is
+ * returned as up to 2 contiguous spans in FIFO order, to be filled from the
+ * start of the first span and then handed to the eTPU with 
+ * etpu_uart_tx_commit().
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_spans - pointer to an array of 2 spans to fill in.
+ *
+ * Returns the total number of free data words in the spans, 0 in TX DMA
+ * mode.
+ **************************************************************************/
+int32_t etpu_uart_tx_reserve(
+    struct uart_instance_t  *p_uart_instance,
+    struct uart_config_t    *p_uart_config,
+    struct uart_fifo_span_t *p_spans);
+
+/**************************************************************************
+ * etpu_uart_tx_commit() - this routine queues for transmission the data
+ * words written into the spans obtained with etpu_uart_tx_reserve().
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * word_cnt - the number of data words written, from the start of the first
+ * span.
+ *
+ * Returns the number of data words pushed onto the TX FIFO, 0 in TX DMA
+ * mode.
+ **************************************************************************/
+int32_t etpu_uart_tx_commit(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    int32_t                 word_cnt);
+
+/**************************************************************************
+ * etpu_uart_rx_ring_fill() - this routine spills the RX FIFO into the host
+ * RX ring (instance rx_ring), in bulk. It is intended to be called from the
+ * RX interrupt handler; data that does not fit in the ring stays in the 
+ * RX FIFO (where RTS flow control, if enabled, applies).
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_overrun_error_status - pointer to where to write the overrun error status.
+ * Ignored if 0/NULL.
+ *
+ * Returns the number of data words moved into the ring.
+ **************************************************************************/
+int32_t etpu_uart_rx_ring_fill(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t               *p_overrun_error_status);
+
+/**************************************************************************
+ * etpu_uart_tx_ring_drain() - this routine refills the TX FIFO from the
+ * host TX ring (instance tx_ring), in bulk. It is intended to be called from
+ * the TX interrupt handler. Since the TX interrupt only fires while data is
+ * being transmitted, the application also calls it (with the TX interrupt
+ * disabled) after etpu_uart_ring_write() when the transmitter may be idle.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * Returns the number of data words moved onto the TX FIFO, 0 in TX DMA
+ * mode.
+ **************************************************************************/
+int32_t etpu_uart_tx_ring_drain(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config);
+
+/**************************************************************************
+ * etpu_uart_ring_read() - this routine reads received data words from the
+ * host RX ring, without accessing the eTPU. The ring has a single producer
+ * (etpu_uart_rx_ring_fill) and a single consumer, so no locking is needed.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_data_buffer - pointer to where to copy the data words.
+ *
+ * data_buffer_size - the maximum number of data words to read.
+ *
+ * Returns the number of data words read.
+ **************************************************************************/
+int32_t etpu_uart_ring_read(
+    struct uart_instance_t *p_uart_instance,
+    union uart_rx_data_t   *p_data_buffer,
+    int32_t                 data_buffer_size);
+
+/**************************************************************************
+ * etpu_uart_ring_write() - this routine queues data words for transmission
+ * on the host TX ring, without accessing the eTPU. The ring has a single
+ * producer and a single consumer (etpu_uart_tx_ring_drain), so no locking is
+ * needed.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_data_buffer - pointer to the data words to transmit.
+ *
+ * data_request_cnt - the number of data words to transmit.
+ *
+ * Returns the number of data words queued on the ring.
+ **************************************************************************/
+int32_t etpu_uart_ring_write(
+    struct uart_instance_t *p_uart_instance,
+    uint32_t               *p_data_buffer,
+    int32_t                 data_request_cnt);
+
+/**************************************************************************
+ * etpu_uart_dispatch_add() - this routine registers the RX/TX channels of a
+ * UART with an interrupt dispatcher. Without a dispatcher handler, an RX
+ * channel needs the instance RX ring, and a TX channel the instance TX ring
+ * or TX DMA mode (the completion of etpu_uart_transmit_data_async() is then
+ * processed).
+ *
+ * p_dispatch - pointer to a UART dispatch structure.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * Returns failure code (UART not on the dispatcher's eTPU, or a channel 
+ * without handler or ring), or pass (0).
+ **************************************************************************/
+int32_t etpu_uart_dispatch_add(
+    struct uart_dispatch_t *p_dispatch,
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config);
+
+/**************************************************************************
+ * etpu_uart_dispatch_interrupts() - this routine services all pending
+ * channel interrupts of the UARTs registered with a dispatcher. The CISR
+ * registers are read and the UART bits cleared once, then all RX channels
+ * are serviced before any TX channel. It is intended to be connected as the
+ * one handler of all the UART channel interrupts of an eTPU.
+ *
+ * p_dispatch - pointer to a UART dispatch structure.
+ *
+ * Returns the number of RX/TX channels serviced.
+ **************************************************************************/
+int32_t etpu_uart_dispatch_interrupts(
+    struct uart_dispatch_t *p_dispatch);
+
 /**************************************************************************
  * etpu_uart_transmit_fifo_status() - this routine retrieves the status of
  * the TX FIFO - its size and the amount used, both in terms of data words.
@@ -210,6 +950,54 @@ int32_t etpu_uart_receive_fifo_status(
     int32_t                *p_fifo_size,
     int32_t                *p_fifo_used);
 
+/**************************************************************************
+ * etpu_uart_autobaud_status() - this routine checks whether the RX channel
+ * has measured the baud rate in auto-baud mode (ETPU_UART_RX_OPTION_AUTO_BAUD).
+ * In that mode the RX channel times the falling edges of a 0x55 sync 
+ * character, which is consumed, sets the bit time and raises the RX channel
+ * interrupt, then goes on receiving at the measured rate. Once measured, this 
+ * routine updates baud_rate_hz and the stop time, TX enable post delay and 
+ * RX idle timeout to match; the TX channel uses the measured bit time too.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_baud_rate_hz - pointer to where to write the measured baud rate, or 
+ * 0/NULL if not wanted.
+ *
+ * Returns 1 once the baud rate has been measured, 0 while still waiting for
+ * the sync character.
+ **************************************************************************/
+int32_t etpu_uart_autobaud_status(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config,
+    uint32_t               *p_baud_rate_hz);
+
+/**************************************************************************
+ * etpu_uart_statistics_snapshot() - this routine reads the statistics kept
+ * by the eTPU, e.g. to size the FIFOs and thresholds from real traffic,
+ * with statistics_enable set. 
+ * Each related pair of values (RX count and overruns, framing and parity 
+ * errors, TX count and CTS stalls, the two high-water marks) is read 
+ * coherently, with the Coherent Dual-Parameter Controller. The four pairs
+ * are read one after the other, so the snapshot as a whole is not 
+ * coherent: the eTPU may update a pair between two reads, e.g. a TX count
+ * may include a character sent after the RX count was read.
+ *
+ * p_uart_instance - pointer to a UART instance structure.
+ *
+ * p_uart_config - pointer to a UART configuration structure.
+ *
+ * p_stats - pointer to where to write the statistics.
+ *
+ * Returns failure code (e.g. statistics not enabled), or pass (0).
+ **************************************************************************/
+int32_t etpu_uart_statistics_snapshot(
+    struct uart_instance_t   *p_uart_instance,
+    struct uart_config_t     *p_uart_config,
+    struct uart_statistics_t *p_stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -86,6 +86,432 @@ void fail_loop()
     g_fail_loop_cnt++;
 }
 
+/* busy wait, for the eTPU to move data meanwhile */
+void wait_us(double time_us)
+{
+    double start_time = read_time();
+    while (read_time() - start_time < time_us)
+        ;
+}
+
+/* poll until the RX FIFO holds word_cnt words, failing after timeout_us */
+void wait_rx_fifo_used(struct uart_instance_t *p_uart_instance, struct uart_config_t *p_uart_config, int32_t word_cnt, double timeout_us)
+{
+    double start_time = read_time();
+    int32_t fifo_used;
+
+    do
+    {
+        etpu_uart_receive_fifo_status(p_uart_instance, p_uart_config, 0, &fifo_used);
+        if (fifo_used >= word_cnt)
+            return;
+    } while (read_time() - start_time < timeout_us);
+    print("error: timeout waiting for RX data");
+    fail_loop();
+}
+
+/* zero-copy access on UART 1: batches of 31 words go through the 80 word 
+   FIFOs, so that at least one batch wraps around the end of each FIFO, then 
+   commits larger than the FIFO content are clamped */
+#define UART_1_SPAN_BATCH_SIZE 31
+void test_uart_1_spans()
+{
+    struct uart_fifo_span_t spans[2];
+    uint32_t i, batch, data_index = 0;
+    int32_t word_cnt, free_cnt;
+    uint32_t overrun_error_status;
+    uint32_t tx_wrapped = 0, rx_wrapped = 0;
+    uint32_t *p_word;
+
+    /* start with an empty RX FIFO */
+    etpu_uart_rx_commit(&uart_1_instance, &uart_1_config, etpu_uart_rx_peek(&uart_1_instance, &uart_1_config, spans), &overrun_error_status);
+    
+    for (batch = 0; batch < 4; batch++)
+    {
+        /* format the words in place, from the start of the first span */
+        free_cnt = etpu_uart_tx_reserve(&uart_1_instance, &uart_1_config, spans);
+        if (free_cnt != (int32_t)uart_1_config.tx_fifo_word_size - 1 || spans[0].word_cnt + spans[1].word_cnt != free_cnt)
+        {
+            print("error: UART 1, TX reserve does not return the whole empty FIFO");
+            fail_loop();
+        }
+        if (spans[0].word_cnt < UART_1_SPAN_BATCH_SIZE)
+            tx_wrapped = 1;
+        for (i = 0; i < UART_1_SPAN_BATCH_SIZE; i++)
+        {
+            if (i < spans[0].word_cnt)
+                p_word = (uint32_t*)spans[0].p_data + i;
+            else
+                p_word = (uint32_t*)spans[1].p_data + (i - spans[0].word_cnt);
+            *p_word = g_uart_1_tx_data[data_index + i];
+        }
+        if (etpu_uart_tx_commit(&uart_1_instance, &uart_1_config, UART_1_SPAN_BATCH_SIZE) != UART_1_SPAN_BATCH_SIZE)
+        {
+            print("error: UART 1, TX commit did not push the batch");
+            fail_loop();
+        }
+        /* 31 words of 18 bits at 200 kbit/s take 2.8 ms */
+        wait_rx_fifo_used(&uart_1_instance, &uart_1_config, UART_1_SPAN_BATCH_SIZE, 4000.0);
+        
+        /* check the words in place, then release them */
+        word_cnt = etpu_uart_rx_peek(&uart_1_instance, &uart_1_config, spans);
+        if (word_cnt != UART_1_SPAN_BATCH_SIZE || spans[0].word_cnt + spans[1].word_cnt != word_cnt)
+        {
+            print("error: UART 1, RX peek does not return the batch");
+            fail_loop();
+        }
+        if (spans[1].word_cnt != 0)
+            rx_wrapped = 1;
+        for (i = 0; i < word_cnt; i++)
+        {
+            if (i < spans[0].word_cnt)
+                p_word = (uint32_t*)spans[0].p_data + i;
+            else
+                p_word = (uint32_t*)spans[1].p_data + (i - spans[0].word_cnt);
+            if (((union uart_rx_data_t*)p_word)->rx_data_word != g_uart_1_tx_data[data_index + i])
+            {
+                print("error: UART 1, RX span data does not match TX data");
+                fail_loop();
+            }
+        }
+        if (etpu_uart_rx_commit(&uart_1_instance, &uart_1_config, word_cnt, &overrun_error_status) != word_cnt || overrun_error_status != 0)
+        {
+            print("error: UART 1, RX commit did not release the batch");
+            fail_loop();
+        }
+        data_index += UART_1_SPAN_BATCH_SIZE;
+    }
+    if (tx_wrapped == 0 || rx_wrapped == 0)
+    {
+        print("error: UART 1, spans did not wrap around the FIFO end");
+        fail_loop();
+    }
+    
+    /* oversized commits only push/release what the FIFO has */
+    free_cnt = etpu_uart_tx_reserve(&uart_1_instance, &uart_1_config, spans);
+    for (i = 0; i < spans[0].word_cnt; i++)
+        ((uint32_t*)spans[0].p_data)[i] = g_uart_1_tx_data[i];
+    for (i = 0; i < spans[1].word_cnt; i++)
+        ((uint32_t*)spans[1].p_data)[i] = g_uart_1_tx_data[spans[0].word_cnt + i];
+    if (etpu_uart_tx_commit(&uart_1_instance, &uart_1_config, free_cnt + 10) != free_cnt)
+    {
+        print("error: UART 1, TX commit not clamped to the free space");
+        fail_loop();
+    }
+    wait_rx_fifo_used(&uart_1_instance, &uart_1_config, free_cnt, 10000.0);
+    word_cnt = etpu_uart_rx_peek(&uart_1_instance, &uart_1_config, spans);
+    if (word_cnt != free_cnt)
+    {
+        print("error: UART 1, RX peek does not return the whole FIFO");
+        fail_loop();
+    }
+    if (etpu_uart_rx_commit(&uart_1_instance, &uart_1_config, word_cnt + 10, &overrun_error_status) != word_cnt ||
+        etpu_uart_rx_commit(&uart_1_instance, &uart_1_config, 1, &overrun_error_status) != 0 ||
+        etpu_uart_rx_peek(&uart_1_instance, &uart_1_config, spans) != 0)
+    {
+        print("error: UART 1, RX commit not clamped to the FIFO content");
+        fail_loop();
+    }
+    if (overrun_error_status != 0)
+    {
+        print("error: UART 1, unexpected overrun");
+        fail_loop();
+    }
+}
+
+
+/* receive and drop whatever is left on UART 2, until its TX FIFO is empty
+   and the line has been quiet for a few characters (both FIFOs hold 20 
+   words at most, so 10 rounds of 500 us are plenty) */
+void flush_uart_2()
+{
+    int32_t fifo_used, round = 0;
+
+    do
+    {
+        if (++round > 10)
+        {
+            print("error: UART 2, could not be flushed");
+            fail_loop();
+            break;
+        }
+        etpu_uart_receive_data(&uart_2_instance, &uart_2_config, g_uart_2_rx_data, UART_2_RX_BUFFER_SIZE, 0);
+        wait_us(500.0);
+        etpu_uart_transmit_fifo_status(&uart_2_instance, &uart_2_config, 0, &fifo_used);
+        if (fifo_used == 0)
+            etpu_uart_receive_fifo_status(&uart_2_instance, &uart_2_config, 0, &fifo_used);
+    } while (fifo_used != 0);
+    /* the last word popped off the TX FIFO may still have been on the line */
+    wait_us(500.0);
+    etpu_uart_receive_data(&uart_2_instance, &uart_2_config, g_uart_2_rx_data, UART_2_RX_BUFFER_SIZE, 0);
+}
+
+/* host rings on UART 2: rounds of 9 words through 13 word rings (12 usable)
+   wrap the ring indexes, so the fill/drain routines work in 2 segments, and
+   wrap the 20 word FIFOs; then a full ring is written, drained and filled */
+#define UART_2_RING_SIZE 13
+#define UART_2_RING_ROUND_SIZE 9
+uint32_t g_uart_2_rx_ring_buffer[UART_2_RING_SIZE];
+uint32_t g_uart_2_tx_ring_buffer[UART_2_RING_SIZE];
+struct uart_ring_t g_uart_2_rx_ring = { g_uart_2_rx_ring_buffer, UART_2_RING_SIZE, 0, 0 };
+struct uart_ring_t g_uart_2_tx_ring = { g_uart_2_tx_ring_buffer, UART_2_RING_SIZE, 0, 0 };
+
+void test_uart_2_rings()
+{
+    uint32_t i, round, data_index = 0;
+    int32_t word_cnt;
+    uint32_t overrun_error_status;
+    uint32_t tmp_tx_buf[16];
+
+    flush_uart_2();
+    uart_2_instance.rx_ring = &g_uart_2_rx_ring;
+    uart_2_instance.tx_ring = &g_uart_2_tx_ring;
+
+    for (round = 0; round < 5; round++)
+    {
+        for (i = 0; i < UART_2_RING_ROUND_SIZE; i++)
+            tmp_tx_buf[i] = g_uart_2_tx_data[(data_index + i) % 32];
+        if (etpu_uart_ring_write(&uart_2_instance, tmp_tx_buf, UART_2_RING_ROUND_SIZE) != UART_2_RING_ROUND_SIZE ||
+            etpu_uart_tx_ring_drain(&uart_2_instance, &uart_2_config) != UART_2_RING_ROUND_SIZE)
+        {
+            print("error: UART 2, TX ring did not pass the round on");
+            fail_loop();
+        }
+        /* 9 words of 11 bits at 100 kbit/s take 1 ms */
+        wait_rx_fifo_used(&uart_2_instance, &uart_2_config, UART_2_RING_ROUND_SIZE, 2000.0);
+        if (etpu_uart_rx_ring_fill(&uart_2_instance, &uart_2_config, &overrun_error_status) != UART_2_RING_ROUND_SIZE ||
+            overrun_error_status != 0)
+        {
+            print("error: UART 2, RX ring did not take the round");
+            fail_loop();
+        }
+        word_cnt = etpu_uart_ring_read(&uart_2_instance, g_uart_2_rx_data, UART_2_RX_BUFFER_SIZE);
+        if (word_cnt != UART_2_RING_ROUND_SIZE)
+        {
+            print("error: UART 2, RX ring read count");
+            fail_loop();
+        }
+        for (i = 0; i < word_cnt; i++)
+        {
+            if (g_uart_2_rx_data[i].rx_data_word != g_uart_2_tx_data[(data_index + i) % 32])
+            {
+                print("error: UART 2, RX ring data does not match TX data");
+                fail_loop();
+            }
+        }
+        data_index += UART_2_RING_ROUND_SIZE;
+    }
+    
+    /* a full ring, what does not fit stays with the caller/in the RX FIFO */
+    for (i = 0; i < 16; i++)
+        tmp_tx_buf[i] = g_uart_2_tx_data[(data_index + i) % 32];
+    if (etpu_uart_ring_write(&uart_2_instance, tmp_tx_buf, 16) != UART_2_RING_SIZE - 1 ||
+        etpu_uart_ring_write(&uart_2_instance, tmp_tx_buf, 1) != 0 ||
+        etpu_uart_tx_ring_drain(&uart_2_instance, &uart_2_config) != UART_2_RING_SIZE - 1 ||
+        etpu_uart_tx_ring_drain(&uart_2_instance, &uart_2_config) != 0)
+    {
+        print("error: UART 2, full TX ring");
+        fail_loop();
+    }
+    wait_rx_fifo_used(&uart_2_instance, &uart_2_config, UART_2_RING_SIZE - 1, 3000.0);
+    if (etpu_uart_rx_ring_fill(&uart_2_instance, &uart_2_config, 0) != UART_2_RING_SIZE - 1 ||
+        etpu_uart_rx_ring_fill(&uart_2_instance, &uart_2_config, 0) != 0)
+    {
+        print("error: UART 2, full RX ring");
+        fail_loop();
+    }
+    word_cnt = etpu_uart_ring_read(&uart_2_instance, g_uart_2_rx_data, UART_2_RX_BUFFER_SIZE);
+    if (word_cnt != UART_2_RING_SIZE - 1)
+    {
+        print("error: UART 2, full RX ring read count");
+        fail_loop();
+    }
+    for (i = 0; i < word_cnt; i++)
+    {
+        if (g_uart_2_rx_data[i].rx_data_word != g_uart_2_tx_data[(data_index + i) % 32])
+        {
+            print("error: UART 2, RX ring data does not match TX data");
+            fail_loop();
+        }
+    }
+    if (etpu_uart_ring_read(&uart_2_instance, g_uart_2_rx_data, UART_2_RX_BUFFER_SIZE) != 0)
+    {
+        print("error: UART 2, RX ring not empty");
+        fail_loop();
+    }
+    uart_2_instance.rx_ring = 0;
+    uart_2_instance.tx_ring = 0;
+}
+
+
+/* RTS on UART 2: rts_halt_threshold words are sent, de-asserting RTS with
+   the TX FIFO empty, so the line stays quiet while the RX FIFO is drained
+   one word at a time with the RX channel disabled; any RTS update HSR then 
+   stays pending and is seen, and exactly one must be issued, by the read
+   crossing rts_resume_threshold */
+void test_uart_2_rts_hsr()
+{
+    volatile struct eTPU_struct * eTPU = eTPU_AB;
+    uint32_t rx_read_index = 0, hsr_cnt = 0;
+    int32_t fifo_used;
+    double start_time;
+
+    etpu_uart_transmit_data(&uart_2_instance, &uart_2_config, g_uart_2_tx_data, uart_2_config.rts_halt_threshold);
+    /* 18 words of 11 bits at 100 kbit/s take 2 ms */
+    wait_rx_fifo_used(&uart_2_instance, &uart_2_config, uart_2_config.rts_halt_threshold, 4000.0);
+    etpu_uart_receive_fifo_status(&uart_2_instance, &uart_2_config, 0, &fifo_used);
+    if (fifo_used != (int32_t)uart_2_config.rts_halt_threshold || eTPU->CHAN[ETPU_UART_2_RTS_CHAN].SCR.B.OPS == 0)
+    {
+        print("error: UART 2, RTS not de-asserted on a full RX FIFO");
+        fail_loop();
+    }
+    
+    fs_etpu_disable_ext(uart_2_instance.em, ETPU_UART_2_RX_CHAN);
+    while (fifo_used > 0)
+    {
+        if (etpu_uart_receive_data(&uart_2_instance, &uart_2_config, g_uart_2_rx_data, 1, 0) != 1 ||
+            g_uart_2_rx_data[0].rx_data_word != g_uart_2_tx_data[rx_read_index++])
+        {
+            print("error: UART 2, RX data does not match TX data");
+            fail_loop();
+        }
+        etpu_uart_receive_fifo_status(&uart_2_instance, &uart_2_config, 0, &fifo_used);
+        if (fs_etpu_get_hsr_ext(uart_2_instance.em, ETPU_UART_2_RX_CHAN) != 0)
+        {
+            hsr_cnt++;
+            if (fifo_used != (int32_t)uart_2_config.rts_resume_threshold)
+            {
+                print("error: UART 2, RTS HSR issued away from the resume threshold");
+                fail_loop();
+            }
+            /* let the eTPU assert RTS */
+            fs_etpu_enable_ext(uart_2_instance.em, ETPU_UART_2_RX_CHAN, uart_2_instance.priority);
+            start_time = read_time();
+            while (fs_etpu_get_hsr_ext(uart_2_instance.em, ETPU_UART_2_RX_CHAN) != 0)
+            {
+                if (read_time() - start_time > 100.0)
+                {
+                    print("error: UART 2, RTS HSR not serviced");
+                    fail_loop();
+                    break;
+                }
+            }
+            fs_etpu_disable_ext(uart_2_instance.em, ETPU_UART_2_RX_CHAN);
+            if (eTPU->CHAN[ETPU_UART_2_RTS_CHAN].SCR.B.OPS != 0)
+            {
+                print("error: UART 2, RTS not asserted at the resume threshold");
+                fail_loop();
+            }
+        }
+    }
+    fs_etpu_enable_ext(uart_2_instance.em, ETPU_UART_2_RX_CHAN, uart_2_instance.priority);
+    if (hsr_cnt != 1)
+    {
+        print("error: UART 2, exactly one RTS HSR expected");
+        fail_loop();
+    }
+}
+
+/* one dispatcher for both UARTs: with RX and TX interrupts pending on 
+   channels 1, 2, 10 and 11, a single dispatch services all of them, the RX
+   channels first, each in channel order */
+struct uart_dispatch_t g_uart_dispatch;
+uint32_t g_dispatch_chan[8];
+uint32_t g_dispatch_cnt = 0;
+
+void dispatch_rx_handler(struct uart_instance_t *p_uart_instance, struct uart_config_t *p_uart_config)
+{
+    if (g_dispatch_cnt < 8)
+        g_dispatch_chan[g_dispatch_cnt++] = p_uart_instance->rx_chan_num;
+    etpu_uart_receive_data(p_uart_instance, p_uart_config, g_uart_1_rx_data, UART_1_RX_BUFFER_SIZE, 0);
+}
+
+void dispatch_tx_handler(struct uart_instance_t *p_uart_instance, struct uart_config_t *p_uart_config)
+{
+    if (g_dispatch_cnt < 8)
+        g_dispatch_chan[g_dispatch_cnt++] = p_uart_instance->tx_chan_num;
+}
+
+void test_dispatch()
+{
+    uint32_t expected_chan[4] = { ETPU_UART_1_RX_CHAN, ETPU_UART_2_RX_CHAN, ETPU_UART_1_TX_CHAN, ETPU_UART_2_TX_CHAN };
+    uint32_t i;
+
+    g_uart_dispatch.em = EM_AB;
+    g_uart_dispatch.rx_handler = dispatch_rx_handler;
+    g_uart_dispatch.tx_handler = dispatch_tx_handler;
+    if (etpu_uart_dispatch_add(&g_uart_dispatch, &uart_1_instance, &uart_1_config) != 0 ||
+        etpu_uart_dispatch_add(&g_uart_dispatch, &uart_2_instance, &uart_2_config) != 0)
+    {
+        print("error: dispatcher rejected a UART");
+        fail_loop();
+    }
+    
+    /* enough words to cross the RX and TX interrupt thresholds of both UARTs */
+    eTPU_AB->CISR_A.R = ETPU_CIE_A;
+    etpu_uart_transmit_data(&uart_1_instance, &uart_1_config, g_uart_1_tx_data, 62);
+    etpu_uart_transmit_data(&uart_2_instance, &uart_2_config, g_uart_2_tx_data, 16);
+    /* 62 words of 18 bits at 200 kbit/s take 5.6 ms, the UART 2 words are in by then */
+    wait_rx_fifo_used(&uart_1_instance, &uart_1_config, 62, 8000.0);
+    wait_rx_fifo_used(&uart_2_instance, &uart_2_config, 16, 1000.0);
+    if (etpu_uart_dispatch_interrupts(&g_uart_dispatch) != 4 || g_dispatch_cnt != 4)
+    {
+        print("error: dispatcher did not service the 4 channels");
+        fail_loop();
+    }
+    for (i = 0; i < 4; i++)
+    {
+        if (g_dispatch_chan[i] != expected_chan[i])
+        {
+            print("error: dispatcher service order");
+            fail_loop();
+        }
+    }
+    if ((eTPU_AB->CISR_A.R & ETPU_CIE_A) != 0 || etpu_uart_dispatch_interrupts(&g_uart_dispatch) != 0)
+    {
+        print("error: dispatcher left interrupts pending");
+        fail_loop();
+    }
+}
+
+
+/* TX DMA mode: the routines that push onto the TX FIFO directly must leave 
+   it to the DMA; checked on UART 1 with a copy of its configuration, so the
+   FIFO must not move */
+uint32_t g_dma_test_ring_buffer[8];
+struct uart_ring_t g_dma_test_ring = { g_dma_test_ring_buffer, 8, 0, 0 };
+
+void test_tx_dma_rejected()
+{
+    struct uart_config_t dma_config = uart_1_config;
+    struct uart_fifo_span_t spans[2];
+    uint8_t tx_bytes[4] = { 1, 2, 3, 4 };
+    int32_t fifo_used, fifo_used_before;
+
+    dma_config.tx_options |= ETPU_UART_TX_OPTION_DMA | ETPU_UART_TX_OPTION_TIMED;
+    uart_1_instance.tx_ring = &g_dma_test_ring;
+    etpu_uart_ring_write(&uart_1_instance, g_uart_1_tx_data, 4);
+    etpu_uart_transmit_fifo_status(&uart_1_instance, &uart_1_config, 0, &fifo_used_before);
+    if (etpu_uart_transmit_data(&uart_1_instance, &dma_config, g_uart_1_tx_data, 4) != 0 ||
+        etpu_uart_transmit_bytes(&uart_1_instance, &dma_config, tx_bytes, 4) != 0 ||
+        etpu_uart_transmit_data_at(&uart_1_instance, &dma_config, 0, g_uart_1_tx_data, 4) != 0 ||
+        etpu_uart_transmit_addressed(&uart_1_instance, &dma_config, 1, g_uart_1_tx_data, 4) != 0 ||
+        etpu_uart_tx_reserve(&uart_1_instance, &dma_config, spans) != 0 ||
+        etpu_uart_tx_commit(&uart_1_instance, &dma_config, 4) != 0 ||
+        etpu_uart_tx_ring_drain(&uart_1_instance, &dma_config) != 0)
+    {
+        print("error: UART 1, TX FIFO push accepted in TX DMA mode");
+        fail_loop();
+    }
+    etpu_uart_transmit_fifo_status(&uart_1_instance, &uart_1_config, 0, &fifo_used);
+    if (fifo_used != fifo_used_before)
+    {
+        print("error: UART 1, TX FIFO changed in TX DMA mode");
+        fail_loop();
+    }
+    uart_1_instance.tx_ring = 0;
+}
+
 
 /* main application entry point */
 /* w/ GNU, if we name this main, it requires linking with the libgcc.a
@@ -300,6 +726,22 @@ int user_main()
         }
     }
 
+    /* zero-copy FIFO access */
+    at_time(60000);
+    test_uart_1_spans();
+
+    /* host ring buffers */
+    test_uart_2_rings();
+
+    /* RTS update HSR only when a read crosses the resume threshold */
+    test_uart_2_rts_hsr();
+    
+    /* interrupt dispatcher */
+    test_dispatch();
+
+    /* no direct TX FIFO pushes in TX DMA mode */
+    test_tx_dma_rejected();
+
 
 	/* TESTING DONE */
 	
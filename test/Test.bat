@@ -55,6 +55,66 @@ echo Running "Parity" Test ...
 %DEVTOOL% -p=Proj.ETpuIdeProj -s=Parity.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
 if  %ERRORLEVEL% NEQ 0 ( goto errors )
 
+echo Running "PackedFifo" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=PackedFifo.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "IdleTimeout" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=IdleTimeout.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "EdgeDecode" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=EdgeDecode.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "RunLength" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=RunLength.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "FractionalBitTime" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=FractionalBitTime.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "AutoBaud" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=AutoBaud.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "Coalesce" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=Coalesce.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "Timestamp" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=Timestamp.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "FrameMode" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=FrameMode.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "Crc" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=Crc.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "Statistics" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=Statistics.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "Overwrite" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=Overwrite.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "TimedTx" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=TimedTx.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "IdlePark" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=IdlePark.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
+echo Running "Multidrop" Test ...
+%DEVTOOL% -p=Proj.ETpuIdeProj -s=Multidrop.ETpuCommand -NoBuild %DEVTOOL_OPTIONS% %1 %2 %3 %4
+if  %ERRORLEVEL% NEQ 0 ( goto errors )
+
 echo .
 echo All UART Single-Target Tests Pass
 
@@ -0,0 +1,24 @@
+#!/bin/sh
+# FILE NAME: build.sh
+# DESCRIPTION:
+# This script builds and runs the Linux host port tests (x86-64, gcc,
+# python3): the etpu_set headers are generated into _host_build, then the
+# unchanged etpu_util_ext.c and etpu_uart.c are compiled with the port, for
+# the port test, the UART model test and the driver benchmark.
+# Run from anywhere; extra arguments are passed to gcc, e.g. -pg.
+
+set -e
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+OUT="$ROOT/_host_build"
+CFLAGS="-O2 -g -Wall -Wno-pointer-to-int-cast -Wno-int-to-pointer-cast -Wno-sign-compare"
+INCLUDES="-I$ROOT/test/host -I$OUT -I$ROOT/etpu/_utils -I$ROOT/etpu/uart"
+SOURCES="$ROOT/test/host/etpu_port.c $ROOT/etpu/_utils/etpu_util_ext.c $ROOT/etpu/uart/etpu_uart.c"
+
+mkdir -p "$OUT"
+python3 "$ROOT/test/host/gen_etpu_set.py" "$OUT"
+gcc $CFLAGS $INCLUDES "$@" -o "$OUT/etpu_port_test" $SOURCES "$ROOT/test/host/etpu_port_test.c"
+gcc $CFLAGS $INCLUDES "$@" -o "$OUT/uart_model_test" $SOURCES "$ROOT/test/host/uart_model.c" "$ROOT/test/host/uart_model_test.c"
+gcc $CFLAGS $INCLUDES "$@" -o "$OUT/etpu_uart_bench" $SOURCES "$ROOT/test/host/etpu_uart_bench.c"
+"$OUT/etpu_port_test"
+"$OUT/uart_model_test"
+"$OUT/etpu_uart_bench"
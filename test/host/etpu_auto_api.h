@@ -0,0 +1,24 @@
+/**************************************************************************
+ * FILE NAME: etpu_auto_api.h                                             *
+ * DESCRIPTION:                                                           *
+ * Host port version of etpu/_etpu_set/etpu_auto_api.h, for the headers    *
+ * generated by gen_etpu_set.py. MSB_BITFIELD_ORDER is not defined, the    *
+ * host allocates bit fields LSB first.                                   *
+ **************************************************************************/
+
+#ifndef ETPU_AUTO_API_H_
+#define ETPU_AUTO_API_H_
+
+#include "etpu_set_defines.h"
+
+/* add defines and types needed by the auto-generated struct file */
+typedef unsigned char   etpu_if_uint8;
+typedef signed char     etpu_if_sint8;
+typedef unsigned short  etpu_if_uint16;
+typedef signed short    etpu_if_sint16;
+typedef unsigned int    etpu_if_uint32;
+typedef signed int      etpu_if_sint32;
+
+#include "etpu_set_struct.h"
+
+#endif /* ETPU_AUTO_API_H_ */
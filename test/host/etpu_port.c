@@ -0,0 +1,428 @@
+/**************************************************************************
+ * FILE NAME: etpu_port.c                                                 *
+ * DESCRIPTION:                                                           *
+ * This file contains the Linux host port of the eTPU register file, data *
+ * RAM and PSE mirror.                                                    *
+ **************************************************************************/
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "etpu_port.h"
+
+/* chip-specific configuration, the MPC5554 memory map of mpc5554_vars.h */
+volatile struct eTPU_struct * const eTPU_AB = (struct eTPU_struct *)ETPU_PORT_REG_BASE;
+volatile struct eTPU_struct * const eTPU_C  = (struct eTPU_struct *)0;
+
+const uint32_t fs_etpu_code_start =     0xC3FD0000;
+const uint32_t fs_etpu_data_ram_start = ETPU_PORT_DATA_RAM_BASE;
+const uint32_t fs_etpu_data_ram_end =   ETPU_PORT_DATA_RAM_BASE + ETPU_PORT_DATA_RAM_SIZE - 4;
+const uint32_t fs_etpu_data_ram_ext =   ETPU_PORT_DATA_RAM_EXT;
+
+const uint32_t fs_etpu_c_code_start =     0x0;
+const uint32_t fs_etpu_c_data_ram_start = 0x0;
+const uint32_t fs_etpu_c_data_ram_end =   0x0;
+const uint32_t fs_etpu_c_data_ram_ext =   0x0;
+
+uint32_t *fs_etpu_free_param;
+uint32_t *fs_etpu_c_free_param;
+
+/* timing configuration, as etpu_gct.c */
+uint32_t etpu_a_tcr1_freq = 132000000/2;
+uint32_t etpu_a_tcr2_freq = 132000000/8;
+uint32_t etpu_b_tcr1_freq = 132000000/2;
+uint32_t etpu_b_tcr2_freq = 132000000/8;
+uint32_t etpu_c_tcr1_freq = 0;
+uint32_t etpu_c_tcr2_freq = 0;
+
+volatile struct eTPU_struct *p_etpu_port_regs;
+etpu_port_write_hook_t etpu_port_write_hook;
+uint32_t etpu_port_trap_cnt;
+
+#define ETPU_PORT_PAGE_SIZE       0x1000
+#define ETPU_PORT_PAGE_WORDS      (ETPU_PORT_PAGE_SIZE / 4)
+#define ETPU_PORT_OPEN_MAX        4    /* pages one instruction can touch */
+#define ETPU_PORT_TRAP_FLAG       0x100
+#define ETPU_PORT_WRITE_MAX       16   /* registers one instruction can write, per page */
+/* data RAM taken by the global data of the eTPU code image, so that no
+   channel frame starts at CPBA 0, which the APIs take for an unallocated one */
+#define ETPU_PORT_GLOBALS_SIZE    0x10
+
+/* SCR status bits, write-one-to-clear */
+#define ETPU_PORT_SCR_CIS         0x80000000
+#define ETPU_PORT_SCR_CIOS        0x40000000
+#define ETPU_PORT_SCR_DTRS        0x00800000
+#define ETPU_PORT_SCR_DTROS       0x00400000
+#define ETPU_PORT_SCR_STATUS      (ETPU_PORT_SCR_CIS | ETPU_PORT_SCR_CIOS | ETPU_PORT_SCR_DTRS | ETPU_PORT_SCR_DTROS)
+#define ETPU_PORT_SCR_FM          0x00000003
+/* CDCR fields */
+#define ETPU_PORT_CDCR_STS        0x80000000
+
+/* a trapped page, opened for the single instruction being stepped */
+struct etpu_port_open_t
+{
+    uint32_t *p_page;
+    uint32_t  fault_word;               /* word index of the faulting access */
+    uint32_t  copy[ETPU_PORT_PAGE_WORDS]; /* registers before, or PSE words presented */
+};
+
+static const uint32_t etpu_port_scr_status_bits[4] =
+{
+    ETPU_PORT_SCR_CIS, ETPU_PORT_SCR_CIOS, ETPU_PORT_SCR_DTRS, ETPU_PORT_SCR_DTROS
+};
+
+static struct etpu_port_open_t etpu_port_open[ETPU_PORT_OPEN_MAX];
+static int32_t etpu_port_open_cnt;
+
+static uint32_t* etpu_port_ram(void)
+{
+    return (uint32_t*)(uintptr_t)fs_etpu_data_ram_start;
+}
+
+/* register file access by offset, logical (big-endian) values */
+static uint32_t etpu_port_reg_get(
+    uint32_t offset)
+{
+    return __builtin_bswap32(((volatile uint32_t*)p_etpu_port_regs)[offset >> 2]);
+}
+
+static void etpu_port_reg_set(
+    uint32_t offset,
+    uint32_t value)
+{
+    ((volatile uint32_t*)p_etpu_port_regs)[offset >> 2] = __builtin_bswap32(value);
+}
+
+/* channel interrupt/DMA status registers, and the matching SCR bit */
+static uint32_t etpu_port_status_scr_bit(
+    uint32_t offset)
+{
+    if (offset == offsetof(struct eTPU_struct, CISR_A) || offset == offsetof(struct eTPU_struct, CISR_B))
+        return ETPU_PORT_SCR_CIS;
+    if (offset == offsetof(struct eTPU_struct, CIOSR_A) || offset == offsetof(struct eTPU_struct, CIOSR_B))
+        return ETPU_PORT_SCR_CIOS;
+    if (offset == offsetof(struct eTPU_struct, CDTRSR_A) || offset == offsetof(struct eTPU_struct, CDTRSR_B))
+        return ETPU_PORT_SCR_DTRS;
+    if (offset == offsetof(struct eTPU_struct, CDTROSR_A) || offset == offsetof(struct eTPU_struct, CDTROSR_B))
+        return ETPU_PORT_SCR_DTROS;
+    return 0;
+}
+
+static uint32_t etpu_port_status_reg(
+    uint32_t scr_bit,
+    uint8_t  engine_b)
+{
+    switch (scr_bit)
+    {
+    case ETPU_PORT_SCR_CIS:
+        return engine_b ? offsetof(struct eTPU_struct, CISR_B) : offsetof(struct eTPU_struct, CISR_A);
+    case ETPU_PORT_SCR_CIOS:
+        return engine_b ? offsetof(struct eTPU_struct, CIOSR_B) : offsetof(struct eTPU_struct, CIOSR_A);
+    case ETPU_PORT_SCR_DTRS:
+        return engine_b ? offsetof(struct eTPU_struct, CDTRSR_B) : offsetof(struct eTPU_struct, CDTRSR_A);
+    default:
+        return engine_b ? offsetof(struct eTPU_struct, CDTROSR_B) : offsetof(struct eTPU_struct, CDTROSR_A);
+    }
+}
+
+/* coherent dual-parameter transfer between two parameters and the buffer */
+static void etpu_port_cdc_transfer(
+    uint32_t value)
+{
+    uint32_t *p_ram = etpu_port_ram();
+    uint32_t ctbase = (value >> 26) & 0x1f;
+    uint32_t buffer = ((value >> 16) & 0x3ff) << 1;
+    uint32_t mask = (value & 0x8000) ? 0xffffffff : 0xffffff;
+    uint32_t param[2], i;
+
+    param[0] = (ctbase << 7) | ((value >> 8) & 0x7f);
+    param[1] = (ctbase << 7) | (value & 0x7f);
+    for (i = 0; i < 2; i++)
+    {
+        if (param[i] >= ETPU_PORT_DATA_RAM_SIZE / 4 || buffer + i >= ETPU_PORT_DATA_RAM_SIZE / 4)
+            continue;
+        if (value & 0x80)
+            p_ram[param[i]] = (p_ram[param[i]] & ~mask) | (p_ram[buffer + i] & mask);
+        else
+            p_ram[buffer + i] = (p_ram[buffer + i] & ~mask) | (p_ram[param[i]] & mask);
+    }
+}
+
+/* give a host register write its semantics */
+static void etpu_port_reg_write(
+    uint32_t offset,
+    uint32_t old_value,
+    uint32_t value)
+{
+    uint32_t scr_bit = etpu_port_status_scr_bit(offset);
+    uint32_t chan_offset, chan_num, bit;
+
+    if (scr_bit != 0)
+    {
+        /* write-one-to-clear, the SCR bits of the channels cleared too */
+        etpu_port_reg_set(offset, old_value & ~value);
+        chan_num = (offset == etpu_port_status_reg(scr_bit, 1)) ? 64 : 0;
+        for (bit = 0; bit < 32; bit++)
+        {
+            if (value & (1u << bit))
+            {
+                chan_offset = offsetof(struct eTPU_struct, CHAN[chan_num + bit].SCR);
+                etpu_port_reg_set(chan_offset, etpu_port_reg_get(chan_offset) & ~scr_bit);
+            }
+        }
+    }
+    else if (offset >= offsetof(struct eTPU_struct, CHAN) && offset < offsetof(struct eTPU_struct, CHAN[127]) &&
+             (offset & 0xf) == offsetof(struct eTPU_struct, CHAN[0].SCR) - offsetof(struct eTPU_struct, CHAN[0]))
+    {
+        /* SCR: status bits write-one-to-clear, in the engine status registers too, function mode
+           bits writable, pin state read-only */
+        chan_num = (offset - offsetof(struct eTPU_struct, CHAN)) >> 4;
+        etpu_port_reg_set(offset, (old_value & ~ETPU_PORT_SCR_FM & ~(value & ETPU_PORT_SCR_STATUS)) | (value & ETPU_PORT_SCR_FM));
+        for (bit = 0; bit < 4; bit++)
+        {
+            scr_bit = etpu_port_scr_status_bits[bit];
+            if (value & scr_bit)
+            {
+                chan_offset = etpu_port_status_reg(scr_bit, chan_num >= 64);
+                etpu_port_reg_set(chan_offset, etpu_port_reg_get(chan_offset) & ~(1u << (chan_num & 0x1f)));
+            }
+        }
+    }
+    else if (offset == offsetof(struct eTPU_struct, CDCR))
+    {
+        if (value & ETPU_PORT_CDCR_STS)
+            etpu_port_cdc_transfer(value);
+        etpu_port_reg_set(offset, value & ~ETPU_PORT_CDCR_STS);
+    }
+    if (etpu_port_write_hook != 0)
+        etpu_port_write_hook(offset, value);
+}
+
+static int32_t etpu_port_in(
+    uintptr_t addr,
+    uintptr_t base,
+    uint32_t  size)
+{
+    return addr >= base && addr < base + size;
+}
+
+/* data RAM words behind a PSE mirror page */
+static uint32_t etpu_port_pse_words(
+    uint32_t *p_page)
+{
+    uint32_t words = (ETPU_PORT_DATA_RAM_EXT + ETPU_PORT_DATA_RAM_SIZE - (uintptr_t)p_page) >> 2;
+
+    return words > ETPU_PORT_PAGE_WORDS ? ETPU_PORT_PAGE_WORDS : words;
+}
+
+/* present the 24 LSBs of the data RAM words in an open PSE page, sign-extended */
+static void etpu_port_pse_present(
+    struct etpu_port_open_t *p_open)
+{
+    uint32_t *p_ram = etpu_port_ram() + (((uintptr_t)p_open->p_page - ETPU_PORT_DATA_RAM_EXT) >> 2);
+    uint32_t i, words = etpu_port_pse_words(p_open->p_page);
+
+    for (i = 0; i < words; i++)
+        p_open->copy[i] = (uint32_t)((int32_t)(p_ram[i] << 8) >> 8);
+    memcpy(p_open->p_page, p_open->copy, words * 4);
+}
+
+/* PSE writes update the 24 LSBs of the data RAM words */
+static void etpu_port_pse_apply(
+    struct etpu_port_open_t *p_open)
+{
+    uint32_t *p_ram = etpu_port_ram() + (((uintptr_t)p_open->p_page - ETPU_PORT_DATA_RAM_EXT) >> 2);
+    uint32_t i, words = etpu_port_pse_words(p_open->p_page);
+
+    for (i = 0; i < words; i++)
+    {
+        if (p_open->p_page[i] != p_open->copy[i])
+            p_ram[i] = (p_ram[i] & 0xff000000) | (p_open->p_page[i] & 0xffffff);
+    }
+}
+
+/* an access to a trapped page: open the page and step the instruction */
+static void etpu_port_fault(
+    int        sig,
+    siginfo_t *p_info,
+    void      *p_context)
+{
+    ucontext_t *p_uc = (ucontext_t*)p_context;
+    uintptr_t addr = (uintptr_t)p_info->si_addr;
+    struct etpu_port_open_t *p_open;
+
+    (void)sig;
+    if (etpu_port_open_cnt == ETPU_PORT_OPEN_MAX ||
+        (!etpu_port_in(addr, ETPU_PORT_REG_BASE, ETPU_PORT_REG_SIZE) &&
+         !etpu_port_in(addr, ETPU_PORT_DATA_RAM_EXT, ETPU_PORT_DATA_RAM_SIZE)))
+    {
+        /* not ours, fault again with the default action */
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+    p_open = &etpu_port_open[etpu_port_open_cnt++];
+    p_open->p_page = (uint32_t*)(addr & ~(uintptr_t)(ETPU_PORT_PAGE_SIZE - 1));
+    p_open->fault_word = (uint32_t)(addr & (ETPU_PORT_PAGE_SIZE - 1)) >> 2;
+    mprotect(p_open->p_page, ETPU_PORT_PAGE_SIZE, PROT_READ | PROT_WRITE);
+    if (etpu_port_in(addr, ETPU_PORT_DATA_RAM_EXT, ETPU_PORT_DATA_RAM_SIZE))
+    {
+        etpu_port_pse_present(p_open);
+    }
+    else
+    {
+        memcpy(p_open->copy, p_open->p_page, ETPU_PORT_PAGE_SIZE);
+    }
+    etpu_port_trap_cnt++;
+    p_uc->uc_mcontext.gregs[REG_EFL] |= ETPU_PORT_TRAP_FLAG;
+}
+
+/* the instruction has been stepped: apply its writes, close the pages */
+static void etpu_port_step(
+    int        sig,
+    siginfo_t *p_info,
+    void      *p_context)
+{
+    ucontext_t *p_uc = (ucontext_t*)p_context;
+    struct etpu_port_open_t *p_open;
+    struct
+    {
+        uint32_t word;
+        uint32_t value;
+    } written[ETPU_PORT_WRITE_MAX];
+    uint32_t i, offset, words;
+    int32_t n;
+
+    (void)sig;
+    (void)p_info;
+    if (etpu_port_open_cnt == 0)
+    {
+        signal(SIGTRAP, SIG_DFL);
+        raise(SIGTRAP);
+        return;
+    }
+    p_uc->uc_mcontext.gregs[REG_EFL] &= ~ETPU_PORT_TRAP_FLAG;
+    for (n = 0; n < etpu_port_open_cnt; n++)
+    {
+        p_open = &etpu_port_open[n];
+        if ((uintptr_t)p_open->p_page >= ETPU_PORT_DATA_RAM_EXT)
+        {
+            etpu_port_pse_apply(p_open);
+            mprotect(p_open->p_page, ETPU_PORT_PAGE_SIZE, PROT_NONE);
+        }
+        else
+        {
+            /* registers: the written ones, and the faulting one even if unchanged (W1C), all found
+               before any is given its semantics, which may change other registers of the page */
+            mprotect(p_open->p_page, ETPU_PORT_PAGE_SIZE, PROT_READ);
+            offset = (uint32_t)((uintptr_t)p_open->p_page - ETPU_PORT_REG_BASE);
+            words = 0;
+            for (i = 0; i < ETPU_PORT_PAGE_WORDS && words < ETPU_PORT_WRITE_MAX; i++)
+            {
+                if (p_open->p_page[i] != p_open->copy[i] || i == p_open->fault_word)
+                {
+                    written[words].word = i;
+                    written[words++].value = p_open->p_page[i];
+                }
+            }
+            for (i = 0; i < words; i++)
+            {
+                etpu_port_reg_write(offset + written[i].word * 4, __builtin_bswap32(p_open->copy[written[i].word]),
+                                    __builtin_bswap32(written[i].value));
+            }
+        }
+    }
+    etpu_port_open_cnt = 0;
+}
+
+int32_t etpu_port_init(void)
+{
+    struct sigaction action;
+    void *p_map;
+    int fd;
+
+    /* register file, shared by the read-only host view and the eTPU view */
+    fd = memfd_create("etpu_regs", 0);
+    if (fd < 0 || ftruncate(fd, ETPU_PORT_REG_SIZE) != 0)
+        return 1;
+    p_map = mmap((void*)ETPU_PORT_REG_BASE, ETPU_PORT_REG_SIZE, PROT_READ, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+    if (p_map != (void*)ETPU_PORT_REG_BASE)
+        return 1;
+    p_map = mmap(0, ETPU_PORT_REG_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p_map == MAP_FAILED)
+        return 1;
+    p_etpu_port_regs = (volatile struct eTPU_struct*)p_map;
+    close(fd);
+
+    p_map = mmap((void*)ETPU_PORT_DATA_RAM_BASE, ETPU_PORT_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (p_map != (void*)ETPU_PORT_DATA_RAM_BASE)
+        return 1;
+    p_map = mmap((void*)ETPU_PORT_DATA_RAM_EXT, ETPU_PORT_PAGE_SIZE, PROT_NONE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (p_map != (void*)ETPU_PORT_DATA_RAM_EXT)
+        return 1;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    action.sa_sigaction = etpu_port_fault;
+    if (sigaction(SIGSEGV, &action, 0) != 0)
+        return 1;
+    action.sa_sigaction = etpu_port_step;
+    if (sigaction(SIGTRAP, &action, 0) != 0)
+        return 1;
+
+    etpu_port_reset();
+    return 0;
+}
+
+void etpu_port_trap(
+    uint8_t enable)
+{
+    static struct etpu_port_open_t pse_open = { (uint32_t*)ETPU_PORT_DATA_RAM_EXT };
+
+    if (enable)
+    {
+        etpu_port_pse_apply(&pse_open);
+        mprotect((void*)ETPU_PORT_DATA_RAM_EXT, ETPU_PORT_PAGE_SIZE, PROT_NONE);
+        mprotect((void*)ETPU_PORT_REG_BASE, ETPU_PORT_REG_SIZE, PROT_READ);
+    }
+    else
+    {
+        mprotect((void*)ETPU_PORT_DATA_RAM_EXT, ETPU_PORT_PAGE_SIZE, PROT_READ | PROT_WRITE);
+        etpu_port_pse_present(&pse_open);
+        mprotect((void*)ETPU_PORT_REG_BASE, ETPU_PORT_REG_SIZE, PROT_READ | PROT_WRITE);
+    }
+}
+
+void etpu_port_reset(void)
+{
+    memset((void*)p_etpu_port_regs, 0, ETPU_PORT_REG_SIZE);
+    memset(etpu_port_ram(), 0, ETPU_PORT_DATA_RAM_SIZE);
+    fs_etpu_free_param = etpu_port_ram() + ETPU_PORT_GLOBALS_SIZE / 4;
+    fs_etpu_c_free_param = 0;
+}
+
+void* etpu_port_data_ram(
+    uint32_t addr)
+{
+    return (uint8_t*)etpu_port_ram() + (addr & 0x3fff);
+}
+
+void etpu_port_interrupt(
+    uint8_t chan_num)
+{
+    uint32_t scr_offset = offsetof(struct eTPU_struct, CHAN[chan_num].SCR);
+    uint32_t scr = etpu_port_reg_get(scr_offset);
+    uint32_t scr_bit = (scr & ETPU_PORT_SCR_CIS) ? ETPU_PORT_SCR_CIOS : ETPU_PORT_SCR_CIS;
+    uint32_t reg_offset = etpu_port_status_reg(scr_bit, chan_num >= 64);
+
+    etpu_port_reg_set(scr_offset, scr | scr_bit);
+    etpu_port_reg_set(reg_offset, etpu_port_reg_get(reg_offset) | (1u << (chan_num & 0x1f)));
+}
@@ -0,0 +1,115 @@
+/**************************************************************************
+ * FILE NAME: etpu_port.h                                                 *
+ * DESCRIPTION:                                                           *
+ * This file contains the prototypes and defines for the Linux host port  *
+ * of the eTPU: a simulated register file and data RAM at the MPC5554     *
+ * addresses, so that etpu_util_ext.c and the eTPU function APIs compile  *
+ * and run unchanged on a workstation.                                    *
+ *========================================================================*/
+
+#ifndef __ETPU_PORT_H
+#define __ETPU_PORT_H
+
+#include "etpu_util_ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**************************************************************************/
+/*                            Definitions                                 */
+/**************************************************************************/
+
+/* The port maps, at the MPC5554 addresses of mpc5554_vars.h (the drivers
+   cast data RAM addresses to 32 bits, so these must be below 4 GB):
+   - the eTPU_AB register file, read-only to the host: each host write
+     faults, is single-stepped and then given its register semantics -
+     write-one-to-clear for the CISR/CDTRSR/CIOSR/CDTROSR registers and the
+     SCR status bits, a coherent dual-parameter transfer for CDCR - before
+     etpu_port_write_hook is called. Channel interrupt (CISR) and SCR CIS
+     bits are kept in step. HSRR keeps the value written, the eTPU side
+     (e.g. the UART model) clears it once the request is serviced.
+   - the data RAM, plain host memory holding host-endian 32-bit words.
+   - the PSE mirror (fs_etpu_data_ram_ext): each access faults, reads
+     return the 24 LSBs of the data RAM word sign-extended, writes update
+     its 24 LSBs only.
+   The eTPU side writes registers through p_etpu_port_regs, a second,
+   writable mapping of the register file that bypasses the trap.
+   The trap relies on the x86-64 trap flag, so the port is x86-64 Linux
+   only, and every trapped access costs two signals: profile the data RAM
+   paths (FIFO copies, ISR dispatch) rather than register or PSE access,
+   or time them with the trap turned off (etpu_port_trap()).
+   Code RAM is not mapped, fs_etpu_init_ext() is not supported. */
+
+#define ETPU_PORT_REG_BASE        0xC3FC0000
+#define ETPU_PORT_REG_SIZE        0x8000
+#define ETPU_PORT_DATA_RAM_BASE   0xC3FC8000
+#define ETPU_PORT_DATA_RAM_SIZE   0x0C00
+#define ETPU_PORT_DATA_RAM_EXT    0xC3FCC000
+
+/* host register write hook: offset in the register file, value written */
+typedef void (*etpu_port_write_hook_t)(uint32_t offset, uint32_t value);
+
+
+/**************************************************************************/
+/*                       Global variables                                 */
+/**************************************************************************/
+
+extern volatile struct eTPU_struct *p_etpu_port_regs;  /* eTPU side view */
+extern etpu_port_write_hook_t etpu_port_write_hook;   /* 0 if none */
+extern uint32_t etpu_port_trap_cnt;                    /* trapped accesses */
+
+
+/**************************************************************************/
+/*                       Function Prototypes                              */
+/**************************************************************************/
+
+/**************************************************************************
+ * etpu_port_init() - this routine maps the register file, the data RAM
+ * and the PSE mirror, installs the access trap and resets them.
+ *
+ * Returns 0 on success, or 1 if the memory map cannot be set up.
+ **************************************************************************/
+int32_t etpu_port_init(void);
+
+/**************************************************************************
+ * etpu_port_reset() - this routine clears the register file and the data
+ * RAM, and frees all data RAM (fs_etpu_free_param).
+ **************************************************************************/
+void etpu_port_reset(void);
+
+/**************************************************************************
+ * etpu_port_trap() - this routine turns the access trap off and on, to
+ * time the host side without the two signals per trapped access. While it
+ * is off, the PSE mirror holds the data RAM as it was when turned off, and
+ * PSE writes reach the data RAM when it is turned back on; host register
+ * writes are plain stores, without their semantics or the write hook.
+ *
+ * enable - 0 to turn the trap off, 1 to turn it back on.
+ **************************************************************************/
+void etpu_port_trap(
+    uint8_t enable);
+
+/**************************************************************************
+ * etpu_port_data_ram() - this routine gets the host address of a data RAM
+ * (eTPU) address.
+ **************************************************************************/
+void* etpu_port_data_ram(
+    uint32_t addr);
+
+/**************************************************************************
+ * etpu_port_interrupt() - this routine raises the interrupt of an eTPU_AB
+ * channel, as the eTPU does: sets its CISR and SCR CIS bits, or its
+ * overflow bits if the interrupt is still pending.
+ *
+ * chan_num - channel number, 0-31 (engine A) or 64-95 (engine B).
+ **************************************************************************/
+void etpu_port_interrupt(
+    uint8_t chan_num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ETPU_PORT_H */
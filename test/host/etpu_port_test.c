@@ -0,0 +1,204 @@
+/**************************************************************************
+ * FILE NAME: etpu_port_test.c                                            *
+ * DESCRIPTION:                                                           *
+ * This file tests the Linux host port of the eTPU (PSE mirror, register  *
+ * semantics, write hook), then runs the unchanged etpu_uart.c on it,     *
+ * playing the eTPU side by hand. Returns non-zero if any check fails.    *
+ **************************************************************************/
+
+#include <stddef.h>
+#include <stdio.h>
+#include "etpu_port.h"
+#include "etpu_auto_api.h"
+#include "etpu_uart.h"
+
+#define RX_CHAN     3
+#define TX_CHAN     4
+#define RTS_CHAN    5
+
+static int32_t g_fail_cnt;
+static uint32_t g_hook_cnt, g_hook_offset, g_hook_value;
+static int32_t g_rx_handler_cnt;
+
+static void check(
+    int         condition,
+    const char *p_msg)
+{
+    if (!condition)
+    {
+        printf("error: %s\n", p_msg);
+        g_fail_cnt++;
+    }
+}
+
+static void write_hook(
+    uint32_t offset,
+    uint32_t value)
+{
+    g_hook_cnt++;
+    g_hook_offset = offset;
+    g_hook_value = value;
+}
+
+static void rx_handler(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config)
+{
+    (void)p_uart_instance;
+    (void)p_uart_config;
+    g_rx_handler_cnt++;
+}
+
+/* the PSE mirror: 24-bit sign-extended reads, writes of the 24 LSBs only */
+static void test_pse(void)
+{
+    uint32_t *p_ram = fs_etpu_malloc_ext(EM_AB, 8);
+    volatile int32_t *p_pse = (volatile int32_t*)((uint32_t)p_ram + fs_etpu_data_ram_ext - fs_etpu_data_ram_start);
+
+    p_ram[0] = 0x12345678;
+    p_ram[1] = 0x00800001;
+    check(p_pse[0] == 0x00345678, "PSE read, positive");
+    check(p_pse[1] == (int32_t)0xff800001, "PSE read, sign extended");
+    p_pse[0] = (int32_t)0xffabcdef;
+    check(p_ram[0] == 0x12abcdef, "PSE write keeps the MSB");
+    check(p_ram[1] == 0x00800001, "PSE write of one word only");
+}
+
+/* register semantics: write-one-to-clear, CDC transfers, write hook */
+static void test_registers(void)
+{
+    uint32_t *p_frame = fs_etpu_malloc_ext(EM_AB, 16);
+    int32_t value1, value2;
+
+    etpu_port_write_hook = write_hook;
+    g_hook_cnt = 0;
+    fs_etpu_set_hsr_ext(EM_AB, RX_CHAN, 3);
+    check(g_hook_cnt == 1 && g_hook_offset == offsetof(struct eTPU_struct, CHAN[RX_CHAN].HSRR) && g_hook_value == 3,
+          "write hook on HSRR");
+    check(fs_etpu_get_hsr_ext(EM_AB, RX_CHAN) == 3, "HSRR keeps the request");
+
+    etpu_port_interrupt(RX_CHAN);
+    etpu_port_interrupt(TX_CHAN);
+    check(eTPU_AB->CISR_A.R == ((1u << RX_CHAN) | (1u << TX_CHAN)), "interrupt sets CISR");
+    check(eTPU_AB->CHAN[RX_CHAN].SCR.B.CIS == 1, "interrupt sets SCR CIS");
+    eTPU_AB->CISR_A.R = 1u << RX_CHAN;
+    check(eTPU_AB->CISR_A.R == (1u << TX_CHAN), "CISR write-one-to-clear");
+    check(eTPU_AB->CHAN[RX_CHAN].SCR.B.CIS == 0 && eTPU_AB->CHAN[TX_CHAN].SCR.B.CIS == 1, "CISR clear clears SCR CIS");
+    /* writing back the value read clears it, though the memory is unchanged by the write */
+    eTPU_AB->CISR_A.R = eTPU_AB->CISR_A.R;
+    check(eTPU_AB->CISR_A.R == 0 && eTPU_AB->CHAN[TX_CHAN].SCR.B.CIS == 0, "CISR write back clears");
+    etpu_port_interrupt(TX_CHAN);
+    etpu_port_interrupt(TX_CHAN);
+    check(eTPU_AB->CIOSR_A.R == (1u << TX_CHAN) && eTPU_AB->CHAN[TX_CHAN].SCR.B.CIOS == 1, "interrupt overflow");
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, TX_CHAN);
+    fs_etpu_clear_chan_interrupt_overflow_flag_ext(EM_AB, TX_CHAN);
+    check(eTPU_AB->CISR_A.R == 0 && eTPU_AB->CIOSR_A.R == 0 && eTPU_AB->CHAN[TX_CHAN].SCR.R == 0, "SCR clear");
+
+    /* coherent read of two 24-bit parameters of a channel frame */
+    eTPU_AB->CHAN[RX_CHAN].CR.R = ((uint32_t)p_frame - fs_etpu_data_ram_start) >> 3;
+    p_frame[1] = 0xaa123456;
+    p_frame[2] = 0x55fedcba;
+    check(fs_etpu_coherent_read_24_ext(EM_AB, RX_CHAN, 5, 9, &value1, &value2) == 0, "coherent read");
+    check(value1 == 0x123456 && value2 == 0xfedcba, "coherent read values");
+    check((eTPU_AB->CDCR.R & 0x80000000) == 0, "CDC transfer done");
+    eTPU_AB->CHAN[RX_CHAN].CR.R = 0;
+    etpu_port_write_hook = 0;
+}
+
+/* etpu_uart.c on the port, the eTPU played by the test */
+static void test_uart(void)
+{
+    struct uart_instance_t inst = { EM_AB, RX_CHAN, TX_CHAN, 0xff, RTS_CHAN, 0xff, FS_ETPU_PRIORITY_MIDDLE };
+    struct uart_config_t cfg = { FS_ETPU_TCR1, 8, ETPU_UART_PARITY_NONE, 115200, 2, 8, 8, 6, 2, 6, 2 };
+    struct uart_dispatch_t dispatch = { EM_AB, rx_handler };
+    struct uart_statistics_t stats;
+    etpu_if_UART_CHANNEL_FRAME *p_frame;
+    union uart_rx_data_t rx_data[8];
+    uint32_t tx_data[10] = { 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a };
+    uint32_t *p_fifo, overrun, i;
+    int32_t used;
+
+    cfg.statistics_enable = 1;
+    check(etpu_uart_init(&inst, &cfg) == 0, "UART init");
+    p_frame = (etpu_if_UART_CHANNEL_FRAME*)inst.cpba;
+    check(eTPU_AB->CHAN[RX_CHAN].CR.R == ((FS_ETPU_PRIORITY_MIDDLE << 28) | (_FUNCTION_NUM_UART_UART_RX_ << 16) |
+          (((uint32_t)inst.cpba & 0x3fff) >> 3)), "RX CR");
+    check(eTPU_AB->CHAN[TX_CHAN].CR.R == ((FS_ETPU_PRIORITY_MIDDLE << 28) | (1 << 25) | (_FUNCTION_NUM_UART_UART_TX_ << 16) |
+          (((uint32_t)inst.cpba & 0x3fff) >> 3)), "TX CR");
+    check(eTPU_AB->CHAN[RTS_CHAN].CR.B.CPBA == eTPU_AB->CHAN[RX_CHAN].CR.B.CPBA && eTPU_AB->CHAN[RTS_CHAN].CR.B.CPR == 0,
+          "RTS CR");
+    check(eTPU_AB->CHAN[RX_CHAN].HSRR.R == ETPU_UART_RX_INIT_TCR1_HSR &&
+          eTPU_AB->CHAN[TX_CHAN].HSRR.R == ETPU_UART_TX_INIT_TCR1_HSR, "init HSRs");
+    check(eTPU_AB->CHAN[RX_CHAN].SCR.B.FM0 == ETPU_UART_FM0_PARITY_DISABLED, "function mode");
+    check(p_frame->_bit_time == 66000000 / 115200 && p_frame->_bit_count == 8 && p_frame->_rts_chan_num == RTS_CHAN,
+          "frame fields");
+    check(p_frame->_rx_buffer_start_p == ((uint32_t)inst.rx_fifo_buffer & 0x3fff) &&
+          p_frame->_rx_buffer_end_p == p_frame->_rx_buffer_start_p + 32 &&
+          p_frame->_rx_rts_resume_threshold == 8, "RX FIFO fields");
+    /* the eTPU services the init HSRs, the init threads reset the FIFO pointers */
+    p_frame->_rx_buffer_pop_p = p_frame->_rx_buffer_push_p = p_frame->_rx_drop_p = p_frame->_rx_buffer_start_p;
+    p_frame->_tx_buffer_pop_p = p_frame->_tx_buffer_push_p = p_frame->_tx_buffer_start_p;
+    p_etpu_port_regs->CHAN[RX_CHAN].HSRR.R = 0;
+    p_etpu_port_regs->CHAN[TX_CHAN].HSRR.R = 0;
+
+    /* TX: words pushed, up to size - 1 */
+    check(etpu_uart_transmit_data(&inst, &cfg, tx_data, 5) == 5, "transmit 5");
+    check(etpu_uart_transmit_data(&inst, &cfg, tx_data + 5, 5) == 2, "transmit, FIFO full");
+    etpu_uart_transmit_fifo_status(&inst, &cfg, 0, &used);
+    check(used == 7, "TX FIFO used");
+    p_fifo = (uint32_t*)inst.tx_fifo_buffer;
+    check(p_fifo[0] == 0x41 && p_fifo[6] == 0x47, "TX FIFO data");
+    /* the eTPU sends 3 words, the FIFO wraps on the next push */
+    p_frame->_tx_buffer_pop_p += 12;
+    check(etpu_uart_transmit_data(&inst, &cfg, tx_data + 7, 3) == 3, "transmit, wrapped");
+    check(p_fifo[7] == 0x48 && p_fifo[0] == 0x49 && p_fifo[1] == 0x4a, "TX FIFO wrapped data");
+
+    /* RX: the eTPU pushes 6 words, the host pops 4, crossing the RTS resume threshold */
+    p_fifo = (uint32_t*)inst.rx_fifo_buffer;
+    for (i = 0; i < 6; i++)
+        p_fifo[i] = 0x30 + i;
+    p_fifo[1] |= ETPU_UART_RX_PARITY_ERROR << 24;
+    p_frame->_rx_buffer_push_p += 24;
+    p_frame->_overrun_error = 1;
+    check(etpu_uart_receive_data(&inst, &cfg, rx_data, 4, &overrun) == 4, "receive 4");
+    check(rx_data[0].rx_data_word == 0x30 && rx_data[1].rx_data_word == (0x31 | (ETPU_UART_RX_PARITY_ERROR << 24)) &&
+          rx_data[3].rx_data_word == 0x33, "RX data");
+    check(overrun == 1 && p_frame->_overrun_error == 0, "overrun status cleared");
+    check(eTPU_AB->CHAN[RX_CHAN].HSRR.R == ETPU_UART_RX_UPDATE_RTS_HSR, "RTS HSR on resume");
+    p_etpu_port_regs->CHAN[RX_CHAN].HSRR.R = 0;
+    check(etpu_uart_receive_data(&inst, &cfg, rx_data, 8, 0) == 2 && rx_data[1].rx_data_word == 0x35, "receive rest");
+    check(eTPU_AB->CHAN[RX_CHAN].HSRR.R == 0, "no RTS HSR below resume");
+
+    /* dispatcher: the pending RX interrupt serviced and cleared */
+    check(etpu_uart_dispatch_add(&dispatch, &inst, &cfg) != 0, "dispatch add without TX service");
+    dispatch.tx_handler = rx_handler;
+    check(etpu_uart_dispatch_add(&dispatch, &inst, &cfg) == 0, "dispatch add");
+    etpu_port_interrupt(RX_CHAN);
+    check(etpu_uart_dispatch_interrupts(&dispatch) == 1 && g_rx_handler_cnt == 1, "dispatch");
+    check(eTPU_AB->CISR_A.R == 0 && eTPU_AB->CHAN[RX_CHAN].SCR.B.CIS == 0, "dispatch clears CISR");
+
+    /* statistics read through the CDC, 24-bit counts */
+    ((uint32_t*)inst.stat_block)[0] = 0xaa000123;
+    ((uint32_t*)inst.stat_block)[1] = 2;
+    ((uint32_t*)inst.stat_block)[4] = 0x00fffffe;
+    ((uint32_t*)inst.stat_block)[6] = 5 * 4;
+    check(etpu_uart_statistics_snapshot(&inst, &cfg, &stats) == 0, "statistics snapshot");
+    check(stats.rx_count == 0x123 && stats.rx_overrun_count == 2 && stats.tx_count == 0xfffffe &&
+          stats.rx_fifo_high_water == 5, "statistics values");
+}
+
+int main(void)
+{
+    if (etpu_port_init() != 0)
+    {
+        printf("error: cannot map the eTPU\n");
+        return 1;
+    }
+    test_pse();
+    etpu_port_reset();
+    test_registers();
+    etpu_port_reset();
+    test_uart();
+    printf("%s: %u trapped accesses, %d failures\n", g_fail_cnt ? "FAIL" : "PASS", etpu_port_trap_cnt, g_fail_cnt);
+    return g_fail_cnt != 0;
+}
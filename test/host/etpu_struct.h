@@ -0,0 +1,16 @@
+/**************************************************************************
+ * FILE NAME: etpu_struct.h                                               *
+ * DESCRIPTION:                                                           *
+ * Host port wrapper of include/etpu_struct.h: the eTPU register layout    *
+ * is MSB first and big-endian, so the bit fields and the R views agree    *
+ * on a little-endian host too.                                           *
+ **************************************************************************/
+
+#ifndef __HOST_ETPU_STRUCT_H
+#define __HOST_ETPU_STRUCT_H
+
+#pragma scalar_storage_order big-endian
+#include "../../include/etpu_struct.h"
+#pragma scalar_storage_order default
+
+#endif /* __HOST_ETPU_STRUCT_H */
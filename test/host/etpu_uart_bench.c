@@ -0,0 +1,315 @@
+/**************************************************************************
+ * FILE NAME: etpu_uart_bench.c                                           *
+ * DESCRIPTION:                                                           *
+ * This file benchmarks the host side of the unchanged etpu_uart.c on the *
+ * Linux host port of the eTPU, the eTPU side being played by hand: the   *
+ * TX/RX FIFO copies per word, for several FIFO sizes and wrap positions, *
+ * and the interrupt dispatcher against one handler per channel, for a    *
+ * growing number of UARTs.                                               *
+ * Returns non-zero if any check fails.                                   *
+ **************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <x86intrin.h>
+#include "etpu_port.h"
+#include "etpu_auto_api.h"
+#include "etpu_uart.h"
+
+#define RX_CHAN     3
+#define TX_CHAN     4
+#define REPEAT_CNT  500
+
+static struct uart_instance_t g_inst;
+static struct uart_config_t g_cfg;
+static uint32_t g_data[128];
+static union uart_rx_data_t g_rx_data[128];
+static int32_t g_fail_cnt;
+
+static void check(
+    int         condition,
+    const char *p_msg)
+{
+    if (!condition)
+    {
+        printf("error: %s\n", p_msg);
+        g_fail_cnt++;
+    }
+}
+
+/* a UART with RX and TX FIFOs of fifo_size words, the FIFO pointers reset as by the init threads */
+static void setup(
+    uint32_t fifo_size)
+{
+    struct uart_instance_t inst = { EM_AB, RX_CHAN, TX_CHAN, 0xff, 0xff, 0xff, FS_ETPU_PRIORITY_MIDDLE };
+    struct uart_config_t cfg = { FS_ETPU_TCR1, 8, ETPU_UART_PARITY_NONE, 115200, 2 };
+    etpu_if_UART_CHANNEL_FRAME *p_frame;
+
+    etpu_port_reset();
+    cfg.rx_fifo_word_size = fifo_size;
+    cfg.tx_fifo_word_size = fifo_size;
+    g_inst = inst;
+    g_cfg = cfg;
+    check(etpu_uart_init(&g_inst, &g_cfg) == 0, "UART init");
+    p_frame = (etpu_if_UART_CHANNEL_FRAME*)g_inst.cpba;
+    p_frame->_rx_buffer_pop_p = p_frame->_rx_buffer_push_p = p_frame->_rx_drop_p = p_frame->_rx_buffer_start_p;
+    p_frame->_tx_buffer_pop_p = p_frame->_tx_buffer_push_p = p_frame->_tx_buffer_start_p;
+}
+
+/* the copy loops of etpu_uart_transmit_data()/etpu_uart_receive_data() before the segment copy, one
+   word per iteration with a wrap check each, for reference */
+static void word_loop_push(
+    uint32_t  push_index,
+    int32_t   word_cnt)
+{
+    uint32_t *push_addr = (uint32_t*)g_inst.tx_fifo_buffer + push_index;
+    uint32_t *end_addr = (uint32_t*)g_inst.tx_fifo_buffer + g_cfg.tx_fifo_word_size;
+    int32_t i;
+
+    for (i = 0; i < word_cnt; i++)
+    {
+        *push_addr++ = g_data[i];
+        if (push_addr == end_addr)
+            push_addr = (uint32_t*)g_inst.tx_fifo_buffer;
+    }
+    ((etpu_if_UART_CHANNEL_FRAME*)g_inst.cpba)->_tx_buffer_push_p = (uint32_t)push_addr & 0x3fff;
+}
+
+static void word_loop_pop(
+    uint32_t  pop_index,
+    int32_t   word_cnt)
+{
+    uint32_t *pop_addr = (uint32_t*)g_inst.rx_fifo_buffer + pop_index;
+    uint32_t *end_addr = (uint32_t*)g_inst.rx_fifo_buffer + g_cfg.rx_fifo_word_size;
+    int32_t read_cnt = 0;
+
+    while (read_cnt < word_cnt)
+    {
+        g_rx_data[read_cnt++].rx_data_word = *pop_addr++;
+        if (pop_addr == end_addr)
+            pop_addr = (uint32_t*)g_inst.rx_fifo_buffer;
+    }
+    ((etpu_if_UART_CHANNEL_FRAME*)g_inst.cpba)->_rx_buffer_pop_p = (uint32_t)pop_addr & 0x3fff;
+}
+
+/* best of REPEAT_CNT timings, in TSC cycles, of a copy of word_cnt words starting at FIFO index start_index:
+   through the driver (driver != 0) or the reference word loop, with the access trap off */
+static uint64_t copy_cycles(
+    uint8_t  tx,
+    uint8_t  driver,
+    uint32_t start_index,
+    int32_t  word_cnt)
+{
+    etpu_if_UART_CHANNEL_FRAME *p_frame = (etpu_if_UART_CHANNEL_FRAME*)g_inst.cpba;
+    uint32_t end_index = (start_index + word_cnt) % g_cfg.rx_fifo_word_size;
+    uint64_t cycles, best = ~(uint64_t)0;
+    int32_t i;
+
+    for (i = 0; i < REPEAT_CNT; i++)
+    {
+        if (tx)
+        {
+            p_frame->_tx_buffer_pop_p = p_frame->_tx_buffer_push_p = p_frame->_tx_buffer_start_p + start_index * 4;
+            etpu_port_trap(0);
+            cycles = __rdtsc();
+            if (driver)
+                etpu_uart_transmit_data(&g_inst, &g_cfg, g_data, word_cnt);
+            else
+                word_loop_push(start_index, word_cnt);
+            cycles = __rdtsc() - cycles;
+            etpu_port_trap(1);
+        }
+        else
+        {
+            p_frame->_rx_buffer_pop_p = p_frame->_rx_drop_p = p_frame->_rx_buffer_start_p + start_index * 4;
+            p_frame->_rx_buffer_push_p = p_frame->_rx_buffer_start_p + end_index * 4;
+            etpu_port_trap(0);
+            cycles = __rdtsc();
+            if (driver)
+                etpu_uart_receive_data(&g_inst, &g_cfg, g_rx_data, word_cnt, 0);
+            else
+                word_loop_pop(start_index, word_cnt);
+            cycles = __rdtsc() - cycles;
+            etpu_port_trap(1);
+        }
+        if (cycles < best)
+            best = cycles;
+    }
+    return best;
+}
+
+/* cycles per word, as the slope between 1 word and a full FIFO, which cancels the fixed cost of a call */
+static double cycles_per_word(
+    uint8_t  tx,
+    uint8_t  driver,
+    uint32_t start_index)
+{
+    int32_t word_cnt = g_cfg.tx_fifo_word_size - 1;
+
+    return ((double)copy_cycles(tx, driver, start_index, word_cnt) - (double)copy_cycles(tx, driver, start_index, 1)) /
+           (word_cnt - 1);
+}
+
+/* FIFO copy: cycles per word for several FIFO sizes and wrap positions */
+static void bench_fifo_copy(void)
+{
+    static const uint32_t fifo_sizes[] = { 16, 32, 64, 128 };
+    etpu_if_UART_CHANNEL_FRAME *p_frame;
+    uint32_t i, j, k, size, start_index[3];
+    int32_t cnt;
+
+    for (i = 0; i < 128; i++)
+        g_data[i] = i * 0x01010101;
+    for (i = 0; i < sizeof(fifo_sizes) / sizeof(fifo_sizes[0]); i++)
+    {
+        size = fifo_sizes[i];
+        setup(size);
+        p_frame = (etpu_if_UART_CHANNEL_FRAME*)g_inst.cpba;
+        /* no wrap, wrap in the middle, wrap after 3 words */
+        start_index[0] = 0;
+        start_index[1] = size / 2;
+        start_index[2] = size - 3;
+        for (j = 0; j < 3; j++)
+        {
+            /* the data gets through both ways across the wrap */
+            p_frame->_tx_buffer_pop_p = p_frame->_tx_buffer_push_p = p_frame->_tx_buffer_start_p + start_index[j] * 4;
+            check(etpu_uart_transmit_data(&g_inst, &g_cfg, g_data, size) == (int32_t)size - 1, "TX copy, count");
+            for (k = 0; k < size - 1; k++)
+                check(((uint32_t*)g_inst.tx_fifo_buffer)[(start_index[j] + k) % size] == g_data[k], "TX copy, data");
+            p_frame->_rx_buffer_pop_p = p_frame->_rx_drop_p = p_frame->_tx_buffer_pop_p - p_frame->_tx_buffer_start_p +
+                p_frame->_rx_buffer_start_p;
+            p_frame->_rx_buffer_push_p = p_frame->_tx_buffer_push_p - p_frame->_tx_buffer_start_p + p_frame->_rx_buffer_start_p;
+            fs_memcpy32_ext(g_inst.rx_fifo_buffer, g_inst.tx_fifo_buffer, size * 4);
+            cnt = etpu_uart_receive_data(&g_inst, &g_cfg, g_rx_data, size, 0);
+            check(cnt == (int32_t)size - 1, "RX copy, count");
+            for (k = 0; k < size - 1; k++)
+                check(g_rx_data[k].rx_data_word == g_data[k], "RX copy, data");
+
+            printf("FIFO copy: %3u words, from index %3u, TSC cycles per word: TX %.2f (word loop %.2f), "
+                   "RX %.2f (word loop %.2f)\n", size, start_index[j],
+                   cycles_per_word(1, 1, start_index[j]), cycles_per_word(1, 0, start_index[j]),
+                   cycles_per_word(0, 1, start_index[j]), cycles_per_word(0, 0, start_index[j]));
+        }
+    }
+}
+
+/* the interrupt dispatcher, UART k on RX channel k of engine A and TX channel k of engine B */
+static struct uart_instance_t g_dispatch_inst[32];
+static struct uart_config_t g_dispatch_cfg[32];
+static uint32_t g_service_cnt;
+
+static void service(
+    struct uart_instance_t *p_uart_instance,
+    struct uart_config_t   *p_uart_config)
+{
+    (void)p_uart_instance;
+    (void)p_uart_config;
+    g_service_cnt++;
+}
+
+/* one handler per channel, as connected by main.c: clear the channel interrupt, service the UART */
+static __attribute__((noinline)) void channel_isr(
+    uint8_t chan_num)
+{
+    uint32_t k = chan_num & 0x1f;
+
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, chan_num);
+    service(&g_dispatch_inst[k], &g_dispatch_cfg[k]);
+}
+
+/* raise the RX and TX interrupts of the first uart_cnt UARTs, as the eTPU does */
+static void raise_all(
+    uint32_t uart_cnt)
+{
+    uint32_t mask = uart_cnt == 32 ? 0xffffffff : (1u << uart_cnt) - 1;
+
+    p_etpu_port_regs->CISR_A.R = mask;
+    p_etpu_port_regs->CISR_B.R = mask;
+}
+
+/* service a burst of all RX and TX interrupts of uart_cnt UARTs, by the dispatcher (dispatch != 0) or one
+   handler call per channel */
+static void service_burst(
+    struct uart_dispatch_t *p_dispatch,
+    uint8_t                 dispatch,
+    uint32_t                uart_cnt)
+{
+    uint32_t k;
+
+    if (dispatch)
+    {
+        etpu_uart_dispatch_interrupts(p_dispatch);
+        return;
+    }
+    for (k = 0; k < uart_cnt; k++)
+        channel_isr((uint8_t)k);
+    for (k = 0; k < uart_cnt; k++)
+        channel_isr((uint8_t)(64 + k));
+}
+
+/* dispatcher: register writes, handler entries and time per burst of all the UART interrupts */
+static void bench_dispatch(void)
+{
+    static const uint32_t uart_cnts[] = { 1, 2, 4, 8, 16, 32 };
+    struct uart_dispatch_t dispatch = { EM_AB, service, service };
+    uint32_t i, j, k, uart_cnt, trap_cnt[2];
+    uint64_t cycles, best[2];
+    uint8_t d;
+
+    etpu_port_reset();
+    for (k = 0; k < 32; k++)
+    {
+        g_dispatch_inst[k].em = EM_AB;
+        g_dispatch_inst[k].rx_chan_num = (uint8_t)k;
+        g_dispatch_inst[k].tx_chan_num = (uint8_t)(64 + k);
+        g_dispatch_inst[k].rts_chan_num = g_dispatch_inst[k].cts_chan_num = g_dispatch_inst[k].txe_chan_num = 0xff;
+    }
+    for (i = 0; i < sizeof(uart_cnts) / sizeof(uart_cnts[0]); i++)
+    {
+        uart_cnt = uart_cnts[i];
+        dispatch.rx_mask[0] = dispatch.rx_mask[1] = dispatch.tx_mask[0] = dispatch.tx_mask[1] = 0;
+        for (k = 0; k < uart_cnt; k++)
+            check(etpu_uart_dispatch_add(&dispatch, &g_dispatch_inst[k], &g_dispatch_cfg[k]) == 0, "dispatch add");
+        for (d = 0; d < 2; d++)
+        {
+            /* with the trap: every interrupt serviced and cleared, register writes counted */
+            raise_all(uart_cnt);
+            g_service_cnt = 0;
+            trap_cnt[d] = etpu_port_trap_cnt;
+            service_burst(&dispatch, d, uart_cnt);
+            trap_cnt[d] = etpu_port_trap_cnt - trap_cnt[d];
+            check(g_service_cnt == 2 * uart_cnt && p_etpu_port_regs->CISR_A.R == 0 && p_etpu_port_regs->CISR_B.R == 0,
+                  "dispatch, interrupts serviced");
+            /* without the trap, timed */
+            best[d] = ~(uint64_t)0;
+            for (j = 0; j < REPEAT_CNT; j++)
+            {
+                raise_all(uart_cnt);
+                etpu_port_trap(0);
+                cycles = __rdtsc();
+                service_burst(&dispatch, d, uart_cnt);
+                cycles = __rdtsc() - cycles;
+                etpu_port_trap(1);
+                if (cycles < best[d])
+                    best[d] = cycles;
+            }
+        }
+        printf("dispatch: %2u UARTs, %2u interrupts, dispatcher 1 handler entry, %u register writes, %lu TSC cycles; "
+               "per channel %u handler entries, %u register writes, %lu TSC cycles\n", uart_cnt, 2 * uart_cnt,
+               trap_cnt[1], (unsigned long)best[1], 2 * uart_cnt, trap_cnt[0], (unsigned long)best[0]);
+        check(trap_cnt[1] == 2 && trap_cnt[0] == 2 * uart_cnt, "dispatch, register writes");
+    }
+}
+
+int main(void)
+{
+    if (etpu_port_init() != 0)
+    {
+        printf("FAIL: eTPU port not set up\n");
+        return 1;
+    }
+    bench_fifo_copy();
+    bench_dispatch();
+    printf("%s\n", g_fail_cnt == 0 ? "PASS" : "FAIL");
+    return g_fail_cnt != 0;
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+##############################################################################
+# FILE NAME: gen_etpu_set.py
+# DESCRIPTION:
+# This script generates the host port stand-ins for the ETEC generated
+# etpu_set_defines.h and etpu_set_struct.h, from the eTPU sources:
+# - the ETPU_UART_* macros, from the export_autodef_macro pragmas of
+#   etec_uart_rx.c and etec_uart_tx.c, resolved against etec_uart.h
+# - the UART channel frame, one 32-bit word per member of the UART class
+#   in etec_uart.h, in declaration order, as etpu_if_UART_CHANNEL_FRAME and
+#   etpu_if_UART_CHANNEL_FRAME_PSE
+# - the frame size, function numbers and entry table attributes
+# The frame layout is the host port's own (ETEC packs 8-bit members next
+# to 24-bit ones), so code using the generated members is portable while
+# code using hard coded frame offsets is not.
+#
+# usage: gen_etpu_set.py <output directory>
+##############################################################################
+
+import os
+import re
+import sys
+
+ETPU_SET_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'etpu', '_etpu_set')
+
+# function numbers and entry table attributes, as ETEC auto-cfsr would assign
+FUNCTIONS = [
+    # entry table, function number, entry table type (0 standard), pin direction (0 input, 1 output)
+    ('UART_RX', 0, 0, 0),
+    ('UART_TX', 1, 0, 1),
+]
+
+
+def read(name):
+    with open(os.path.join(ETPU_SET_DIR, name)) as f:
+        return f.read()
+
+
+def strip_comments(text):
+    text = re.sub(r'/\*.*?\*/', '', text, flags=re.S)
+    return re.sub(r'//[^\n]*', '', text)
+
+
+def frame_members(header):
+    """(name, signed) for each data member of the UART class, in order"""
+    body = header[header.index('_eTPU_class UART'):]
+    body = strip_comments(body[body.index('{') + 1:body.index('/* threads */')])
+    members = []
+    for decl in body.split(';'):
+        decl = re.sub(r'\b(public|private)\s*:', '', decl).strip()
+        if not decl:
+            continue
+        m = re.match(r'(.+?)\s*(\**)\s*(\w+)$', decl, re.S)
+        if m is None:
+            sys.exit('gen_etpu_set.py: cannot parse UART member "%s"' % decl)
+        type_name, pointer, name = m.group(1), m.group(2), m.group(3)
+        signed = pointer == '' and type_name in ('int8_t', 'int16_t', 'int24_t', 'int32_t')
+        members.append((name, signed))
+    return members
+
+
+def autodef_macros(header, sources):
+    """(name, value) of each export_autodef_macro, symbols resolved"""
+    defines = dict(re.findall(r'^\s*#define\s+(\w+)\s+(\S+)', strip_comments(header), re.M))
+    macros = []
+    for source in sources:
+        for name, value in re.findall(r'#pragma\s+export_autodef_macro\s+"(\w+)"\s*,\s*(\w+)', source):
+            while value in defines:
+                value = defines[value]
+            macros.append((name, value))
+    return macros
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit('usage: gen_etpu_set.py <output directory>')
+    out_dir = sys.argv[1]
+    header = read('etec_uart.h')
+    members = frame_members(header)
+    macros = autodef_macros(header, [read('etec_uart_rx.c'), read('etec_uart_tx.c')])
+    frame_size = (len(members) * 4 + 7) & ~7
+
+    lines = ['/* etpu_set_defines.h - generated by test/host/gen_etpu_set.py, do not edit */',
+             '#ifndef __ETPU_SET_DEFINES_H', '#define __ETPU_SET_DEFINES_H', '']
+    lines.append('#define _FRAME_SIZE_UART_ 0x%02x' % frame_size)
+    for table, number, table_type, pin_dir in FUNCTIONS:
+        lines.append('#define _FUNCTION_NUM_UART_%s_ %d' % (table, number))
+        lines.append('#define _ENTRY_TABLE_TYPE_UART_%s_ %d' % (table, table_type))
+        lines.append('#define _ENTRY_TABLE_PIN_DIR_UART_%s_ %d' % (table, pin_dir))
+    lines.append('')
+    for name, value in macros:
+        lines.append('#define %s %s' % (name, value))
+    lines += ['', '#endif', '']
+    with open(os.path.join(out_dir, 'etpu_set_defines.h'), 'w') as f:
+        f.write('\n'.join(lines))
+
+    lines = ['/* etpu_set_struct.h - generated by test/host/gen_etpu_set.py, do not edit */',
+             '#ifndef __ETPU_SET_STRUCT_H', '#define __ETPU_SET_STRUCT_H', '']
+    for suffix in ('', '_PSE'):
+        lines.append('typedef struct')
+        lines.append('{')
+        for name, signed in members:
+            lines.append('    %s %s;' % ('etpu_if_sint32' if signed else 'etpu_if_uint32', name))
+        lines.append('} etpu_if_UART_CHANNEL_FRAME%s;' % suffix)
+        lines.append('')
+    lines += ['#endif', '']
+    with open(os.path.join(out_dir, 'etpu_set_struct.h'), 'w') as f:
+        f.write('\n'.join(lines))
+
+
+if __name__ == '__main__':
+    main()
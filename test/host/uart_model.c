@@ -0,0 +1,1064 @@
+/**************************************************************************
+ * FILE NAME: uart_model.c                                                *
+ * DESCRIPTION:                                                           *
+ * This file contains a host-native model of the UART eTPU function: the  *
+ * threads of etec_uart_rx.c and etec_uart_tx.c, translated to C, and the *
+ * channel hardware and TCR1 event queue that drive them.                 *
+ **************************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+#include "etpu_auto_api.h"
+#include "etpu_uart.h"
+#include "uart_model.h"
+
+struct uart_model_t uart_model;
+
+/* output/input pin actions, as OPAC_ and IPAC_ of ETpu_Std.h */
+#define OPAC_NO_CHANGE   0
+#define OPAC_MATCH_HIGH  1
+#define OPAC_MATCH_LOW   2
+#define IPAC_NO_DETECT   0
+#define IPAC_FALLING     1
+#define IPAC_EITHER      2
+
+/* event types */
+#define EVENT_MATCH      0
+#define EVENT_TRANSITION 1
+#define EVENT_FAULT      2    /* line fault starts or ends */
+#define EVENT_ISR        3
+
+#define EVENT_QUEUE_SIZE 1024
+
+#define RX_OPTIONS_SUPPORTED (ETPU_UART_RX_OPTION_PACKED_FIFO | ETPU_UART_RX_OPTION_EDGE_DECODE | ETPU_UART_RX_OPTION_OVERWRITE)
+#define TX_OPTIONS_SUPPORTED (ETPU_UART_TX_OPTION_PACKED_FIFO | ETPU_UART_TX_OPTION_RUN_LENGTH | ETPU_UART_TX_OPTION_IDLE_PARK)
+
+/* channel hardware */
+struct uart_model_chan_t
+{
+    uint8_t  pin;           /* pin level, as driven or as seen by the input */
+    uint8_t  opac;          /* pin action on match A */
+    uint8_t  ipac;          /* transition detection */
+    uint8_t  flag0;
+    uint8_t  sink;          /* input channel the pin drives, 0xff if none */
+    uint8_t  line;          /* input: level of the driving pin */
+    uint8_t  fault;         /* input: line fault inverting the level */
+    uint8_t  isr_pending;   /* host interrupt handler call queued */
+    uint8_t  hsr_pending;
+    uint32_t match_seq;     /* sequence number of the armed match A, 0 if none */
+};
+
+struct uart_model_event_t
+{
+    int64_t  time;
+    uint32_t seq;           /* same time events in the order queued */
+    uint8_t  chan_num;
+    uint8_t  type;
+};
+
+/* the thread being run, as the eTPU chan and erta registers */
+struct uart_model_engine_t
+{
+    uint8_t  chan;
+    uint32_t erta;          /* 24 bits */
+    etpu_if_UART_CHANNEL_FRAME *p_frame;
+};
+
+static struct uart_model_chan_t uart_model_chan[UART_MODEL_CHAN_CNT];
+static struct uart_model_event_t uart_model_queue[EVENT_QUEUE_SIZE];
+static int32_t uart_model_queue_cnt;
+static uint32_t uart_model_seq;
+static uint8_t uart_model_hsr_any;
+static struct uart_model_engine_t eng;
+static uint8_t uart_model_port_ready;
+
+
+/**************************************************************************/
+/*                       Event queue (binary heap)                        */
+/**************************************************************************/
+
+static int32_t uart_model_event_before(
+    const struct uart_model_event_t *p_a,
+    const struct uart_model_event_t *p_b)
+{
+    return p_a->time < p_b->time || (p_a->time == p_b->time && p_a->seq < p_b->seq);
+}
+
+static uint32_t uart_model_queue_event(
+    int64_t time,
+    uint8_t chan_num,
+    uint8_t type)
+{
+    struct uart_model_event_t event;
+    int32_t i = uart_model_queue_cnt, parent;
+
+    if (uart_model_queue_cnt == EVENT_QUEUE_SIZE)
+    {
+        if (uart_model.p_error == 0)
+            uart_model.p_error = "event queue full";
+        return 0;
+    }
+    event.time = time;
+    event.seq = ++uart_model_seq;
+    event.chan_num = chan_num;
+    event.type = type;
+    uart_model_queue_cnt++;
+    while (i > 0)
+    {
+        parent = (i - 1) >> 1;
+        if (!uart_model_event_before(&event, &uart_model_queue[parent]))
+            break;
+        uart_model_queue[i] = uart_model_queue[parent];
+        i = parent;
+    }
+    uart_model_queue[i] = event;
+    return event.seq;
+}
+
+static void uart_model_pop_event(
+    struct uart_model_event_t *p_event)
+{
+    struct uart_model_event_t last;
+    int32_t i = 0, child;
+
+    *p_event = uart_model_queue[0];
+    last = uart_model_queue[--uart_model_queue_cnt];
+    for (;;)
+    {
+        child = 2 * i + 1;
+        if (child >= uart_model_queue_cnt)
+            break;
+        if (child + 1 < uart_model_queue_cnt && uart_model_event_before(&uart_model_queue[child + 1], &uart_model_queue[child]))
+            child++;
+        if (!uart_model_event_before(&uart_model_queue[child], &last))
+            break;
+        uart_model_queue[i] = uart_model_queue[child];
+        i = child;
+    }
+    uart_model_queue[i] = last;
+}
+
+
+/**************************************************************************/
+/*                       Channel hardware                                 */
+/**************************************************************************/
+
+static void uart_model_error(
+    const char *p_error)
+{
+    if (uart_model.p_error == 0)
+        uart_model.p_error = p_error;
+}
+
+/* sign-extend a 24-bit or 8-bit data RAM value */
+static int32_t s24(
+    uint32_t value)
+{
+    return (int32_t)(value << 8) >> 8;
+}
+
+static int32_t s8(
+    uint32_t value)
+{
+    return (int8_t)value;
+}
+
+static uint32_t* ram32(
+    uint32_t offset)
+{
+    return (uint32_t*)etpu_port_data_ram(offset);
+}
+
+static uint8_t* ram8(
+    uint32_t offset)
+{
+    return (uint8_t*)etpu_port_data_ram(offset);
+}
+
+/* count in a 24-bit statistics word */
+static void stat_add(
+    uint32_t *p_count)
+{
+    *p_count = (*p_count + 1) & 0xffffff;
+}
+
+static uint8_t fm0(void)
+{
+    return p_etpu_port_regs->CHAN[eng.chan].SCR.B.FM0;
+}
+
+/* arm match A, a time up to half the TCR1 range behind matches at once (greater-equal comparator) */
+static void match_write(
+    uint8_t  chan_num,
+    uint32_t time)
+{
+    uint32_t delay = (time - (uint32_t)uart_model.time) & 0xffffff;
+
+    if (delay >= 0x800000)
+        delay = 0;
+    uart_model_chan[chan_num].match_seq = uart_model_queue_event(uart_model.time + delay, chan_num, EVENT_MATCH);
+}
+
+static void match_disable(
+    uint8_t chan_num)
+{
+    uart_model_chan[chan_num].match_seq = 0;
+}
+
+static void input_level(
+    uint8_t chan_num)
+{
+    struct uart_model_chan_t *p_chan = &uart_model_chan[chan_num];
+    uint8_t level = p_chan->line ^ p_chan->fault;
+
+    if (level == p_chan->pin)
+        return;
+    p_chan->pin = level;
+    if ((p_chan->ipac == IPAC_FALLING && level == 0) || p_chan->ipac == IPAC_EITHER)
+        uart_model_queue_event(uart_model.time, chan_num, EVENT_TRANSITION);
+}
+
+static void pin_set(
+    uint8_t chan_num,
+    uint8_t level)
+{
+    struct uart_model_chan_t *p_chan = &uart_model_chan[chan_num];
+
+    p_chan->pin = level;
+    if (p_chan->sink != 0xff)
+    {
+        uart_model_chan[p_chan->sink].line = level;
+        input_level(p_chan->sink);
+    }
+}
+
+/* channel.CIRC = CIRC_INT_FROM_SERVICED */
+static void interrupt(void)
+{
+    struct uart_model_chan_t *p_chan = &uart_model_chan[eng.chan];
+    int64_t delay = 0;
+
+    etpu_port_interrupt(eng.chan);
+    uart_model.int_cnt[eng.chan]++;
+    if (uart_model.isr == 0 || p_chan->isr_pending)
+        return;
+    if (uart_model.isr_delay != 0)
+        delay = uart_model.isr_delay(eng.chan);
+    p_chan->isr_pending = 1;
+    uart_model_queue_event(uart_model.time + delay, eng.chan, EVENT_ISR);
+}
+
+
+/**************************************************************************/
+/*                       RX threads (etec_uart_rx.c)                      */
+/**************************************************************************/
+
+static void ArmIdle_fragment(void);
+static void ReceiveStop_fragment(void);
+
+static void Init_RX_TCR1(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    struct uart_model_chan_t *p_chan = &uart_model_chan[eng.chan];
+
+    if ((f->_rx_options & ~RX_OPTIONS_SUPPORTED) != 0)
+        uart_model_error("RX option not supported");
+    p_chan->ipac = IPAC_FALLING;
+    p_chan->flag0 = 0;
+    match_disable(eng.chan);
+
+    f->_rx_buffer_pop_p = f->_rx_buffer_push_p = f->_rx_drop_p = f->_rx_buffer_start_p;
+    f->_rx_coalesce_pending = 0;
+    f->_rx_addressed = 0;
+    f->_rx_data_mask = (1 << s8(f->_bit_count)) - 1;
+    if (s8(f->_rts_chan_num) >= 0)
+        pin_set(f->_rts_chan_num, 0);
+}
+
+static void Shutdown_RX(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+
+    uart_model_chan[eng.chan].ipac = IPAC_NO_DETECT;
+    match_disable(eng.chan);
+    if (s8(f->_rts_chan_num) >= 0)
+        pin_set(f->_rts_chan_num, 1);
+}
+
+static void DetectWord(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    struct uart_model_chan_t *p_chan = &uart_model_chan[eng.chan];
+    int32_t bit_time = s24(f->_bit_time);
+    int32_t running, frac;
+
+    f->_rx_one_bit = 1;
+    f->_rx_shift_register = 0;
+    f->_rx_parity_calc = 0;
+    f->_rx_start_time = eng.erta;
+    running = s8(f->_bit_count);
+    if (fm0() == ETPU_UART_FM0_PARITY_ENABLED)
+    {
+        f->_rx_parity_calc = f->_parity_select;
+        running += 1;
+    }
+    f->_rx_running_bit_count = running;
+    if (f->_rx_options & ETPU_UART_RX_OPTION_EDGE_DECODE)
+    {
+        /* edge decode: service only the transitions within the word, then a single match in the middle of
+           the stop bit */
+        f->_rx_edge_start_time = eng.erta;
+        f->_rx_edge_cell = 0;
+        f->_rx_edge_level = 0;
+        eng.erta += bit_time * (running + 1) + (bit_time >> 1) + ((f->_bit_time_frac * (2 * running + 3)) >> 9);
+        match_write(eng.chan, eng.erta);
+        p_chan->ipac = IPAC_EITHER;
+        p_chan->flag0 = 1;
+    }
+    else
+    {
+        /* first sample 1.5 bit times out, including the fractional part */
+        frac = f->_bit_time_frac + (f->_bit_time_frac >> 1);
+        eng.erta += bit_time + (bit_time >> 1) + (frac >> 8);
+        f->_rx_frac_acc = frac & 0xff;
+        match_write(eng.chan, eng.erta);
+        p_chan->ipac = IPAC_NO_DETECT;
+    }
+}
+
+static void DetectBit(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    int32_t running = s8(f->_rx_running_bit_count);
+
+    if (running < 0)
+    {
+        /* idle timeout and/or coalescing latency timeout, line quiet since last stop bit */
+        if (f->_rx_coalesce_pending != 0 && s24(eng.erta - f->_rx_coalesce_start_time) >= s24(f->_rx_coalesce_timeout))
+        {
+            f->_rx_coalesce_pending = 0;
+            interrupt();
+        }
+        if (f->_rx_idle_timeout != 0 && ((eng.erta ^ f->_rx_idle_time) & 0xffffff) == 0)
+        {
+            if (f->_rx_buffer_push_p != f->_rx_buffer_pop_p)
+            {
+                f->_rx_coalesce_pending = 0;
+                interrupt();
+            }
+        }
+        ArmIdle_fragment();
+    }
+    else if (running == 0)
+    {
+        ReceiveStop_fragment();
+    }
+    else
+    {
+        f->_rx_running_bit_count = running - 1;
+        if (uart_model_chan[eng.chan].pin == 1)
+        {
+            f->_rx_shift_register |= f->_rx_one_bit;
+            f->_rx_parity_calc = (f->_rx_parity_calc + 1) & 0xff;
+        }
+        f->_rx_one_bit = (f->_rx_one_bit << 1) & 0xffffff;
+        eng.erta += s24(f->_bit_time);
+        if (f->_rx_frac_acc + f->_bit_time_frac > 0xff)
+            eng.erta += 1; /* fractional part carry */
+        f->_rx_frac_acc = (f->_rx_frac_acc + f->_bit_time_frac) & 0xff;
+        match_write(eng.chan, eng.erta);
+    }
+}
+
+static void DetectEdge(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    int32_t bit_time = s24(f->_bit_time);
+    int32_t cell, elapsed, edge_cell = s8(f->_rx_edge_cell);
+
+    /* round the edge time to the nearest bit cell boundary, cell N boundary being N bit times plus N
+       fractional parts out */
+    elapsed = s24(eng.erta - f->_rx_edge_start_time);
+    cell = (elapsed + (bit_time >> 1)) / bit_time;
+    elapsed -= (f->_bit_time_frac * cell) >> 8;
+    cell = (elapsed + (bit_time >> 1)) / bit_time;
+    if (cell > s8(f->_rx_running_bit_count) + 1)
+        cell = s8(f->_rx_running_bit_count) + 1;
+    else if (cell < 1)
+        cell = 1; /* glitch within the start bit */
+    if (f->_rx_edge_level != 0)
+    {
+        /* all cells since the last edge were ones, data bit N is cell N+1 */
+        f->_rx_shift_register |= ((1u << (cell - 1)) - (1u << (edge_cell - 1))) & 0xffffff;
+        f->_rx_parity_calc = (f->_rx_parity_calc + cell - edge_cell) & 0xff;
+    }
+    f->_rx_edge_cell = cell;
+    f->_rx_edge_level ^= 1;
+}
+
+static void DetectEdgeStop(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    int32_t cell, edge_cell = s8(f->_rx_edge_cell);
+
+    uart_model_chan[eng.chan].flag0 = 0;
+    if (f->_rx_edge_level != 0)
+    {
+        /* the line has been high since the last edge */
+        cell = s8(f->_rx_running_bit_count) + 1;
+        f->_rx_shift_register |= ((1u << (cell - 1)) - (1u << (edge_cell - 1))) & 0xffffff;
+        f->_rx_parity_calc = (f->_rx_parity_calc + cell - edge_cell) & 0xff;
+    }
+    f->_rx_running_bit_count = 0;
+    ReceiveStop_fragment();
+}
+
+/* overwrite-oldest policy: the oldest word is whichever of pop and _rx_drop_p is fewer bytes behind push */
+static uint32_t OldestRxWord(
+    uint32_t pop_p)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    int32_t pop_used = (int32_t)f->_rx_buffer_push_p - (int32_t)pop_p;
+    int32_t drop_used = (int32_t)f->_rx_buffer_push_p - (int32_t)f->_rx_drop_p;
+
+    if (pop_used < 0)
+        pop_used += s24(f->_rx_buffer_byte_size);
+    if (drop_used < 0)
+        drop_used += s24(f->_rx_buffer_byte_size);
+    if (drop_used < pop_used)
+        return f->_rx_drop_p;
+    return pop_p;
+}
+
+static void rts_update(
+    int32_t fifo_used_size)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+
+    if (fifo_used_size >= s24(f->_rx_rts_halt_threshold))
+        pin_set(f->_rts_chan_num, 1);
+    else if (fifo_used_size <= s24(f->_rx_rts_resume_threshold))
+        pin_set(f->_rts_chan_num, 0);
+}
+
+static void ReceiveStop_fragment(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    struct uart_stat_block_t *p_stat = f->_stat_block_p ? (struct uart_stat_block_t*)ram32(f->_stat_block_p) : 0;
+    uint32_t error_flags = 0, data = f->_rx_shift_register & f->_rx_data_mask;
+    uint32_t word_p = f->_rx_buffer_push_p, next_p, pop_p, map_p;
+    int32_t fifo_used_size, entry_size, char_index, shift;
+
+    /* this is the stop bit, check it */
+    if (uart_model_chan[eng.chan].pin == 0)
+        error_flags |= ETPU_UART_RX_FRAMING_ERROR;
+    if (fm0() == ETPU_UART_FM0_PARITY_ENABLED && (f->_rx_parity_calc & 1) != 0)
+        error_flags |= ETPU_UART_RX_PARITY_ERROR;
+    if (p_stat != 0)
+    {
+        stat_add(&p_stat->rx_count);
+        if (error_flags & ETPU_UART_RX_FRAMING_ERROR)
+            stat_add(&p_stat->framing_error_count);
+        if (error_flags & ETPU_UART_RX_PARITY_ERROR)
+            stat_add(&p_stat->parity_error_count);
+    }
+    /* re-enable check for start bit */
+    uart_model_chan[eng.chan].ipac = IPAC_FALLING;
+    f->_rx_idle_time = (eng.erta + f->_rx_idle_timeout) & 0xffffff;
+
+    /* always put data in */
+    if (f->_rx_options & ETPU_UART_RX_OPTION_PACKED_FIFO)
+    {
+        /* one character per byte, error flags kept in a separate map */
+        *ram8(word_p) = (uint8_t)data;
+        char_index = (int32_t)word_p - (int32_t)f->_rx_buffer_start_p;
+        map_p = f->_rx_error_map_p + (char_index >> 2);
+        shift = (char_index & 3) << 1;
+        *ram8(map_p) = (uint8_t)((*ram8(map_p) & ~(3 << shift)) | (error_flags << shift));
+        next_p = word_p + 1;
+    }
+    else
+    {
+        *ram32(word_p) = (error_flags << 24) | data;
+        next_p = word_p + 4;
+    }
+
+    /* was there room in FIFO? error if not, otherwise increment push */
+    pop_p = f->_rx_buffer_pop_p;
+    if (f->_rx_options & ETPU_UART_RX_OPTION_OVERWRITE)
+        pop_p = OldestRxWord(pop_p);
+    entry_size = (int32_t)next_p - (int32_t)word_p;
+    if (next_p == f->_rx_buffer_end_p)
+        next_p = f->_rx_buffer_start_p;
+    if (f->_rx_options & ETPU_UART_RX_OPTION_OVERWRITE)
+    {
+        if (next_p == pop_p)
+        {
+            /* freshest wins: drop the oldest word to make room for this one */
+            f->_overrun_error = 1;
+            if (p_stat != 0)
+                stat_add(&p_stat->rx_overrun_count);
+            pop_p += entry_size;
+            if (pop_p == f->_rx_buffer_end_p)
+                pop_p = f->_rx_buffer_start_p;
+        }
+        f->_rx_drop_p = pop_p;
+    }
+    if (next_p == pop_p)
+    {
+        f->_overrun_error = 1;
+        /* data dropped */
+        if (p_stat != 0)
+            stat_add(&p_stat->rx_overrun_count);
+    }
+    else
+    {
+        f->_rx_buffer_push_p = next_p;
+
+        /* issue interrupt if threshold reached */
+        fifo_used_size = (int32_t)next_p - (int32_t)pop_p;
+        if (fifo_used_size < 0)
+            fifo_used_size += s24(f->_rx_buffer_byte_size);
+        if (p_stat != 0 && fifo_used_size > s24(p_stat->rx_fifo_high_water))
+            p_stat->rx_fifo_high_water = fifo_used_size;
+        if (f->_rx_coalesce_timeout != 0)
+        {
+            /* coalescing: one interrupt per count of words received, or once the first of them has waited
+               the latency timeout */
+            if (f->_rx_coalesce_pending == 0)
+                f->_rx_coalesce_start_time = eng.erta & 0xffffff;
+            f->_rx_coalesce_pending += 1;
+            if (s24(f->_rx_coalesce_pending) >= s24(f->_rx_coalesce_count) ||
+                s24(eng.erta - f->_rx_coalesce_start_time) >= s24(f->_rx_coalesce_timeout))
+            {
+                f->_rx_coalesce_pending = 0;
+                interrupt();
+            }
+        }
+        else if (fifo_used_size == s24(f->_rx_fifo_int_threshold))
+        {
+            interrupt();
+        }
+
+        /* update RTS output if feature enabled and threshold crossed */
+        if (s8(f->_rts_chan_num) >= 0)
+            rts_update(fifo_used_size);
+    }
+    ArmIdle_fragment();
+}
+
+static void ArmIdle_fragment(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    uint32_t match_time = 0, latency_time;
+    uint8_t armed = 0;
+
+    /* arm one match for whichever of the idle timeout and the coalescing latency timeout comes first,
+       a start bit replaces it */
+    if (f->_rx_idle_timeout != 0 && s24(f->_rx_idle_time - eng.erta) > 0)
+    {
+        match_time = f->_rx_idle_time;
+        armed = 1;
+    }
+    if (f->_rx_coalesce_pending != 0)
+    {
+        latency_time = f->_rx_coalesce_start_time + f->_rx_coalesce_timeout;
+        if (armed == 0 || s24(latency_time - match_time) < 0)
+        {
+            match_time = latency_time;
+            armed = 1;
+        }
+    }
+    if (armed)
+    {
+        f->_rx_running_bit_count = -1;
+        eng.erta = match_time;
+        match_write(eng.chan, eng.erta);
+    }
+}
+
+static void UpdateRTS(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    uint32_t pop_p = f->_rx_buffer_pop_p;
+    int32_t fifo_used_size;
+
+    if (s8(f->_rts_chan_num) >= 0)
+    {
+        if (f->_rx_options & ETPU_UART_RX_OPTION_OVERWRITE)
+            pop_p = OldestRxWord(pop_p);
+        fifo_used_size = (int32_t)f->_rx_buffer_push_p - (int32_t)pop_p;
+        if (fifo_used_size < 0)
+            fifo_used_size += s24(f->_rx_buffer_byte_size);
+        rts_update(fifo_used_size);
+    }
+}
+
+
+/**************************************************************************/
+/*                       TX threads (etec_uart_tx.c)                      */
+/**************************************************************************/
+
+static void FinishTXE_fragment(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+
+    if (f->_tx_enable_active != 0)
+    {
+        /* this is the end of an RS-485 mode transfer, set up end of TX enable */
+        f->_tx_enable_active = 0;
+        match_write(f->_tx_enable_chan_num, eng.erta + f->_tx_enable_post_delay);
+    }
+}
+
+static void Init_TX_TCR1(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    struct uart_model_chan_t *p_chan = &uart_model_chan[eng.chan];
+
+    if ((f->_tx_options & ~TX_OPTIONS_SUPPORTED) != 0)
+        uart_model_error("TX option not supported");
+    eng.erta = (uint32_t)uart_model.time & 0xffffff;
+    if (s8(f->_tx_enable_chan_num) >= 0)
+    {
+        pin_set(f->_tx_enable_chan_num, 0);
+        uart_model_chan[f->_tx_enable_chan_num].opac = OPAC_MATCH_LOW;
+    }
+    p_chan->opac = OPAC_NO_CHANGE;
+    pin_set(eng.chan, 1);
+    p_chan->flag0 = 0;
+    eng.erta += s24(f->_stop_time);
+    match_write(eng.chan, eng.erta);
+
+    /* clear FIFO to start */
+    f->_tx_buffer_pop_p = f->_tx_buffer_push_p = f->_tx_buffer_start_p;
+    if (f->_stat_block_p != 0)
+        ((struct uart_stat_block_t*)ram32(f->_stat_block_p))->tx_cts_stalled = 0;
+    f->_tx_parked = 0;
+}
+
+static void Shutdown_TX(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+
+    match_disable(eng.chan);
+    pin_set(eng.chan, 1);
+    if (s8(f->_tx_enable_chan_num) >= 0)
+    {
+        match_disable(f->_tx_enable_chan_num);
+        pin_set(f->_tx_enable_chan_num, 0);
+    }
+}
+
+static void TransmitCheck(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    struct uart_model_chan_t *p_chan = &uart_model_chan[eng.chan];
+    struct uart_stat_block_t *p_stat = f->_stat_block_p ? (struct uart_stat_block_t*)ram32(f->_stat_block_p) : 0;
+    uint32_t pop_p, push_p, frame, one_bit;
+    int32_t fifo_used_size, i;
+
+    eng.erta += s24(f->_stop_time);
+    match_write(eng.chan, eng.erta);
+    pop_p = f->_tx_buffer_pop_p;
+    push_p = f->_tx_buffer_push_p;
+    if (pop_p != push_p)
+    {
+        /* if CTS enabled and not active, do not send */
+        if (s8(f->_cts_chan_num) >= 0)
+        {
+            if (uart_model_chan[f->_cts_chan_num].pin == 1)
+            {
+                /* not clear to send, must wait */
+                if (p_stat != 0 && p_stat->tx_cts_stalled == 0)
+                {
+                    p_stat->tx_cts_stalled = 1;
+                    stat_add(&p_stat->cts_stall_count);
+                }
+                FinishTXE_fragment();
+                return;
+            }
+            if (p_stat != 0)
+                p_stat->tx_cts_stalled = 0;
+        }
+
+        /* if in 485 mode, update tx enable */
+        if (s8(f->_tx_enable_chan_num) >= 0)
+        {
+            match_disable(f->_tx_enable_chan_num);
+            pin_set(f->_tx_enable_chan_num, 1);
+            f->_tx_enable_active = 1;
+        }
+
+        p_chan->opac = OPAC_MATCH_LOW;
+        p_chan->flag0 = 1;
+        f->_tx_parity_calc = f->_parity_select;
+        f->_tx_running_bit_count = f->_bit_count;
+        f->_tx_frac_acc = 0;
+        if (p_stat != 0)
+            stat_add(&p_stat->tx_count);
+
+        fifo_used_size = (int32_t)push_p - (int32_t)pop_p;
+        if (fifo_used_size < 0)
+            fifo_used_size += s24(f->_tx_buffer_byte_size);
+        if (p_stat != 0 && fifo_used_size > s24(p_stat->tx_fifo_high_water))
+            p_stat->tx_fifo_high_water = fifo_used_size;
+
+        /* get the next word, update pop ptr and interrupt host if necessary */
+        if (f->_tx_options & ETPU_UART_TX_OPTION_PACKED_FIFO)
+        {
+            f->_tx_shift_register = *ram8(pop_p);
+            pop_p += 1;
+        }
+        else
+        {
+            f->_tx_shift_register = *ram32(pop_p) & 0xffffff;
+            pop_p += 4;
+        }
+        if (pop_p == f->_tx_buffer_end_p)
+            pop_p = f->_tx_buffer_start_p;
+        f->_tx_buffer_pop_p = pop_p;
+
+        fifo_used_size = (int32_t)push_p - (int32_t)pop_p;
+        if (fifo_used_size < 0)
+            fifo_used_size += s24(f->_tx_buffer_byte_size);
+        if (fifo_used_size == s24(f->_tx_fifo_int_threshold))
+            interrupt();
+
+        if (f->_tx_options & ETPU_UART_TX_OPTION_RUN_LENGTH)
+        {
+            /* run-length mode: mask the data bits and append the parity bit */
+            frame = 0;
+            one_bit = 1;
+            for (i = 0; i < s8(f->_bit_count); i++)
+            {
+                if ((f->_tx_shift_register & one_bit) != 0)
+                {
+                    frame |= one_bit;
+                    f->_tx_parity_calc = (f->_tx_parity_calc + 1) & 0xff;
+                }
+                one_bit <<= 1;
+            }
+            if (fm0() == ETPU_UART_FM0_PARITY_ENABLED)
+            {
+                if ((f->_tx_parity_calc & 1) != 0)
+                    frame |= one_bit;
+                f->_tx_running_bit_count += 1;
+            }
+            f->_tx_shift_register = frame & 0xffffff;
+            f->_tx_level = 0; /* start bit */
+        }
+    }
+    else
+    {
+        if (f->_tx_options & ETPU_UART_TX_OPTION_IDLE_PARK)
+        {
+            /* idle park: stop polling until the host pushes data and wakes the channel */
+            f->_tx_parked = 1;
+            if (f->_tx_buffer_push_p != pop_p)
+                f->_tx_parked = 0;
+            else
+                match_disable(eng.chan);
+        }
+        FinishTXE_fragment();
+    }
+}
+
+static void Wake_TX_TCR1(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+
+    if (f->_tx_parked != 0)
+    {
+        /* the host has pushed data onto the empty TX FIFO, check it right away */
+        eng.erta = (uint32_t)uart_model.time & 0xffffff;
+        f->_tx_parked = 0;
+        match_write(eng.chan, eng.erta);
+    }
+}
+
+static void TransmitBit(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *f = eng.p_frame;
+    struct uart_model_chan_t *p_chan = &uart_model_chan[eng.chan];
+    int32_t running = s8(f->_tx_running_bit_count);
+    int32_t bit_time = s24(f->_bit_time), run_time;
+
+    if (f->_tx_options & ETPU_UART_TX_OPTION_RUN_LENGTH)
+    {
+        /* run-length mode: skip the bits at the current level and schedule a single match for the next
+           level change */
+        run_time = bit_time;
+        if (f->_tx_frac_acc + f->_bit_time_frac > 0xff)
+            run_time += 1; /* fractional part carry */
+        f->_tx_frac_acc = (f->_tx_frac_acc + f->_bit_time_frac) & 0xff;
+        while (running > 0 && (f->_tx_shift_register & 1) == f->_tx_level)
+        {
+            run_time += bit_time;
+            if (f->_tx_frac_acc + f->_bit_time_frac > 0xff)
+                run_time += 1;
+            f->_tx_frac_acc = (f->_tx_frac_acc + f->_bit_time_frac) & 0xff;
+            f->_tx_shift_register >>= 1;
+            running -= 1;
+        }
+        if (running > 0)
+        {
+            f->_tx_level ^= 1;
+            f->_tx_shift_register >>= 1;
+            running -= 1;
+            p_chan->opac = f->_tx_level ? OPAC_MATCH_HIGH : OPAC_MATCH_LOW;
+        }
+        else
+        {
+            /* rest of the word is at stop level, next match is start of stop bit */
+            p_chan->opac = OPAC_MATCH_HIGH;
+            p_chan->flag0 = 0;
+        }
+        f->_tx_running_bit_count = running;
+        eng.erta += run_time;
+        match_write(eng.chan, eng.erta);
+        return;
+    }
+    if (running == 0)
+    {
+        if (fm0() == ETPU_UART_FM0_PARITY_DISABLED)
+        {
+            /* no parity; issue stop bit */
+            p_chan->opac = OPAC_MATCH_HIGH;
+            p_chan->flag0 = 0;
+        }
+        else
+        {
+            p_chan->opac = (f->_tx_parity_calc & 1) ? OPAC_MATCH_HIGH : OPAC_MATCH_LOW;
+        }
+    }
+    else if (running < 0)
+    {
+        /* issue stop bit */
+        p_chan->opac = OPAC_MATCH_HIGH;
+        p_chan->flag0 = 0;
+    }
+    else
+    {
+        p_chan->opac = OPAC_MATCH_LOW;
+        if ((f->_tx_shift_register & 1) != 0)
+        {
+            p_chan->opac = OPAC_MATCH_HIGH;
+            f->_tx_parity_calc = (f->_tx_parity_calc + 1) & 0xff;
+        }
+    }
+    f->_tx_running_bit_count = running - 1;
+    f->_tx_shift_register >>= 1;
+    eng.erta += bit_time;
+    if (f->_tx_frac_acc + f->_bit_time_frac > 0xff)
+        eng.erta += 1; /* fractional part carry */
+    f->_tx_frac_acc = (f->_tx_frac_acc + f->_bit_time_frac) & 0xff;
+    match_write(eng.chan, eng.erta);
+}
+
+
+/**************************************************************************/
+/*                       Entry tables                                     */
+/**************************************************************************/
+
+/* run the thread of a channel for an HSR (0 if none), a match or a transition */
+static void uart_model_service(
+    uint8_t  chan_num,
+    uint32_t hsr,
+    uint8_t  match)
+{
+    volatile struct eTPU_struct *p_regs = p_etpu_port_regs;
+    uint8_t flag0 = uart_model_chan[chan_num].flag0;
+
+    if (p_regs->CHAN[chan_num].CR.B.CPR == 0)
+        return; /* channel disabled, pin actions only */
+    eng.chan = chan_num;
+    eng.erta = (uint32_t)uart_model.time & 0xffffff;
+    eng.p_frame = (etpu_if_UART_CHANNEL_FRAME*)etpu_port_data_ram(p_regs->CHAN[chan_num].CR.B.CPBA << 3);
+    uart_model.thread_cnt[chan_num]++;
+    if (p_regs->CHAN[chan_num].CR.B.CFS == _FUNCTION_NUM_UART_UART_RX_)
+    {
+        switch (hsr)
+        {
+        case ETPU_UART_RX_UPDATE_RTS_HSR: UpdateRTS(); break;
+        case ETPU_UART_RX_INIT_TCR1_HSR:  Init_RX_TCR1(); break;
+        case ETPU_UART_RX_SHUTDOWN_HSR:   Shutdown_RX(); break;
+        case 0:
+            if (match)
+                flag0 ? DetectEdgeStop() : DetectBit();
+            else
+                flag0 ? DetectEdge() : DetectWord();
+            break;
+        default:
+            uart_model_error(hsr == ETPU_UART_RX_INIT_TCR2_HSR ? "TCR2 not supported" : "unexpected RX thread");
+            break;
+        }
+    }
+    else if (p_regs->CHAN[chan_num].CR.B.CFS == _FUNCTION_NUM_UART_UART_TX_)
+    {
+        switch (hsr)
+        {
+        case ETPU_UART_TX_WAKE_TCR1_HSR: Wake_TX_TCR1(); break;
+        case ETPU_UART_TX_INIT_TCR1_HSR: Init_TX_TCR1(); break;
+        case ETPU_UART_TX_SHUTDOWN_HSR:  Shutdown_TX(); break;
+        case 0:
+            if (match)
+                flag0 ? TransmitBit() : TransmitCheck();
+            else
+                uart_model_error("unexpected TX thread");
+            break;
+        default:
+            uart_model_error(hsr == ETPU_UART_TX_INIT_TCR2_HSR || hsr == ETPU_UART_TX_WAKE_TCR2_HSR ?
+                             "TCR2 not supported" : "unexpected TX thread");
+            break;
+        }
+    }
+    else
+    {
+        uart_model_error("not a UART channel");
+    }
+}
+
+static void uart_model_service_hsrs(void);
+
+/* host register writes: service the HSRs at once, as the eTPU does within microseconds, the driver
+   writes HSRR before it enables the channel (CR) */
+static void uart_model_write_hook(
+    uint32_t offset,
+    uint32_t value)
+{
+    uint32_t chan_num, reg;
+
+    if (offset < offsetof(struct eTPU_struct, CHAN) || offset >= offsetof(struct eTPU_struct, CHAN[UART_MODEL_CHAN_CNT]))
+        return;
+    chan_num = (offset - offsetof(struct eTPU_struct, CHAN)) >> 4;
+    reg = offset & 0xf;
+    if (reg != offsetof(struct eTPU_struct, CHAN[0].HSRR) - offsetof(struct eTPU_struct, CHAN[0]) &&
+        reg != offsetof(struct eTPU_struct, CHAN[0].CR) - offsetof(struct eTPU_struct, CHAN[0]))
+        return;
+    uart_model_chan[chan_num].hsr_pending = 1;
+    uart_model_hsr_any = 1;
+    uart_model_service_hsrs();
+}
+
+static void uart_model_service_hsrs(void)
+{
+    uint32_t hsr;
+    uint8_t chan_num;
+
+    while (uart_model_hsr_any)
+    {
+        uart_model_hsr_any = 0;
+        for (chan_num = 0; chan_num < UART_MODEL_CHAN_CNT; chan_num++)
+        {
+            if (uart_model_chan[chan_num].hsr_pending == 0)
+                continue;
+            uart_model_chan[chan_num].hsr_pending = 0;
+            hsr = p_etpu_port_regs->CHAN[chan_num].HSRR.R;
+            if (hsr == 0 || p_etpu_port_regs->CHAN[chan_num].CR.B.CPR == 0)
+                continue; /* kept in HSRR until the channel is enabled */
+            p_etpu_port_regs->CHAN[chan_num].HSRR.R = 0;
+            uart_model.hsr_cnt[chan_num]++;
+            uart_model_service(chan_num, hsr, 0);
+        }
+    }
+}
+
+
+/**************************************************************************/
+/*                       Interface                                        */
+/**************************************************************************/
+
+int32_t uart_model_init(void)
+{
+    uint8_t chan_num;
+
+    if (uart_model_port_ready == 0)
+    {
+        if (etpu_port_init() != 0)
+            return 1;
+        uart_model_port_ready = 1;
+    }
+    else
+    {
+        etpu_port_reset();
+    }
+    memset(&uart_model, 0, sizeof(uart_model));
+    memset(uart_model_chan, 0, sizeof(uart_model_chan));
+    for (chan_num = 0; chan_num < UART_MODEL_CHAN_CNT; chan_num++)
+        uart_model_chan[chan_num].sink = 0xff;
+    uart_model_queue_cnt = 0;
+    uart_model_seq = 0;
+    uart_model_hsr_any = 0;
+    etpu_port_write_hook = uart_model_write_hook;
+    return 0;
+}
+
+void uart_model_wire(
+    uint8_t out_chan_num,
+    uint8_t in_chan_num)
+{
+    uart_model_chan[out_chan_num].sink = in_chan_num;
+    if (in_chan_num != 0xff)
+    {
+        uart_model_chan[in_chan_num].line = uart_model_chan[out_chan_num].pin;
+        input_level(in_chan_num);
+    }
+}
+
+void uart_model_line_fault(
+    uint8_t in_chan_num,
+    int64_t start_time,
+    int64_t end_time)
+{
+    uart_model_queue_event(start_time, in_chan_num, EVENT_FAULT);
+    uart_model_queue_event(end_time, in_chan_num, EVENT_FAULT);
+}
+
+void uart_model_run(
+    int64_t end_time)
+{
+    struct uart_model_event_t event;
+    struct uart_model_chan_t *p_chan;
+
+    for (;;)
+    {
+        if (uart_model_queue_cnt == 0 || uart_model_queue[0].time > end_time)
+            break;
+        uart_model_pop_event(&event);
+        uart_model.time = event.time;
+        p_chan = &uart_model_chan[event.chan_num];
+        switch (event.type)
+        {
+        case EVENT_MATCH:
+            if (event.seq != p_chan->match_seq)
+                break; /* replaced or disabled since */
+            p_chan->match_seq = 0;
+            if (p_chan->opac == OPAC_MATCH_HIGH)
+                pin_set(event.chan_num, 1);
+            else if (p_chan->opac == OPAC_MATCH_LOW)
+                pin_set(event.chan_num, 0);
+            uart_model_service(event.chan_num, 0, 1);
+            break;
+        case EVENT_TRANSITION:
+            uart_model_service(event.chan_num, 0, 0);
+            break;
+        case EVENT_FAULT:
+            p_chan->fault ^= 1;
+            input_level(event.chan_num);
+            break;
+        case EVENT_ISR:
+            p_chan->isr_pending = 0;
+            uart_model.isr(event.chan_num);
+            break;
+        }
+    }
+    if (end_time > uart_model.time)
+        uart_model.time = end_time;
+}
+
+uint8_t uart_model_pin(
+    uint8_t chan_num)
+{
+    return uart_model_chan[chan_num].pin;
+}
@@ -0,0 +1,122 @@
+/**************************************************************************
+ * FILE NAME: uart_model.h                                                *
+ * DESCRIPTION:                                                           *
+ * This file contains the prototypes and defines for a host-native model  *
+ * of the UART eTPU function, run on the Linux host port of the eTPU.     *
+ *========================================================================*/
+
+#ifndef __UART_MODEL_H
+#define __UART_MODEL_H
+
+#include <stdint.h>
+#include "etpu_port.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**************************************************************************/
+/*                            Definitions                                 */
+/**************************************************************************/
+
+/* The model runs the UART class threads of etec_uart_rx.c/etec_uart_tx.c,
+   translated to C, on the channel frames etpu_uart.c sets up in the port
+   data RAM, so etpu_uart.c is driven unchanged. A discrete-event TCR1 clock
+   (one event queue of channel matches, pin transitions and host interrupt
+   calls) drives them through the entry tables, with the channel hardware
+   they use: match A with its output pin action, transition detection on
+   input channels, FLAG0, the FM0 function mode bit, pin levels and
+   channel interrupts. HSRs written by the host are serviced at once.
+   Output channels can be wired to input channels (e.g. TX to RX, RTS to
+   CTS), with line faults inverting the level seen by the input for a time.
+   Threads take no time and TCR1 counts the modeled time, so the model
+   gives thread counts and word/interrupt timing, not eTPU loading.
+   Supported: parity, packed FIFOs, edge decode, run-length TX, overwrite-
+   oldest, RTS/CTS, RS-485 TX enable, statistics, idle timeout, coalescing
+   and idle park, on TCR1. Anything else (DMA, auto-baud, timestamp, frame
+   and CRC modes, multidrop, timed TX, TCR2) stops at the init thread with
+   p_error set. */
+
+#define UART_MODEL_CHAN_CNT      96   /* eTPU_AB channels 0-31 and 64-95 */
+
+
+/**************************************************************************/
+/*                       Structures and types                             */
+/**************************************************************************/
+
+struct uart_model_t
+{
+    int64_t     time;                 /* TCR1 counts since uart_model_init() */
+    /* optional host interrupt handler, called for a channel interrupt once
+       isr_delay() TCR1 counts have passed (no delay if isr_delay is 0/NULL);
+       further interrupts of the channel meanwhile are merged into that call */
+    void        (*isr)(uint8_t chan_num);
+    int64_t     (*isr_delay)(uint8_t chan_num);
+    /* counts, per channel */
+    uint32_t    thread_cnt[UART_MODEL_CHAN_CNT];
+    uint32_t    hsr_cnt[UART_MODEL_CHAN_CNT];
+    uint32_t    int_cnt[UART_MODEL_CHAN_CNT];
+    const char *p_error;              /* first unsupported feature or unexpected thread, 0 if none */
+};
+
+
+/**************************************************************************/
+/*                       Global variables                                 */
+/**************************************************************************/
+
+extern struct uart_model_t uart_model;
+
+
+/**************************************************************************/
+/*                       Function Prototypes                              */
+/**************************************************************************/
+
+/**************************************************************************
+ * uart_model_init() - this routine sets up the eTPU port (cleared register
+ * file and data RAM), and resets the model, its counts and wiring.
+ *
+ * Returns 0 on success, or 1 if the eTPU port cannot be set up.
+ **************************************************************************/
+int32_t uart_model_init(void);
+
+/**************************************************************************
+ * uart_model_wire() - this routine connects the pin of an output channel
+ * to an input channel, e.g. a TX channel to an RX channel.
+ *
+ * out_chan_num - output channel number.
+ *
+ * in_chan_num - input channel number, or 0xff to disconnect.
+ **************************************************************************/
+void uart_model_wire(
+    uint8_t out_chan_num,
+    uint8_t in_chan_num);
+
+/**************************************************************************
+ * uart_model_line_fault() - this routine inverts the level seen by an
+ * input channel from start_time to end_time.
+ **************************************************************************/
+void uart_model_line_fault(
+    uint8_t in_chan_num,
+    int64_t start_time,
+    int64_t end_time);
+
+/**************************************************************************
+ * uart_model_run() - this routine advances the model to end_time, in TCR1
+ * counts, servicing the HSRs, matches and transitions and calling the host
+ * interrupt handler in time order.
+ **************************************************************************/
+void uart_model_run(
+    int64_t end_time);
+
+/**************************************************************************
+ * uart_model_pin() - this routine gets the pin level of a channel.
+ **************************************************************************/
+uint8_t uart_model_pin(
+    uint8_t chan_num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_MODEL_H */
@@ -0,0 +1,742 @@
+/**************************************************************************
+ * FILE NAME: uart_model_test.c                                           *
+ * DESCRIPTION:                                                           *
+ * This file runs the unchanged etpu_uart.c on the UART model: basic      *
+ * mode, parity, framing error, overrun and flow control scenarios, a     *
+ * throughput benchmark, and the measurements of the optional modes.      *
+ * Returns non-zero if any scenario fails.                                *
+ **************************************************************************/
+
+#include <stdio.h>
+#include <time.h>
+#include "etpu_auto_api.h"
+#include "etpu_uart.h"
+#include "uart_model.h"
+
+#define RX_CHAN     3
+#define TX_CHAN     4
+#define RTS_CHAN    5
+#define CTS_CHAN    6
+#define BAUD_RATE   660000  /* 100 TCR1 counts per bit */
+#define BUFFER_SIZE 256
+
+static struct uart_instance_t g_inst;
+static struct uart_config_t g_cfg;
+static uint32_t g_tx_data[BUFFER_SIZE];
+static union uart_rx_data_t g_rx_data[BUFFER_SIZE];
+static int32_t g_tx_index, g_tx_total, g_rx_index;
+static uint32_t g_rx_errors;
+static int32_t g_fail_cnt;
+
+static void check(
+    int         condition,
+    const char *p_msg)
+{
+    if (!condition)
+    {
+        printf("error: %s\n", p_msg);
+        g_fail_cnt++;
+    }
+}
+
+/* RX/TX channels looped back, optional RTS to CTS loop */
+static void setup(
+    uint8_t  parity_select,
+    uint8_t  bit_count,
+    uint32_t rx_fifo_word_size,
+    uint8_t  flow_control)
+{
+    struct uart_instance_t inst = { EM_AB, RX_CHAN, TX_CHAN, 0xff, 0xff, 0xff, FS_ETPU_PRIORITY_MIDDLE };
+    struct uart_config_t cfg = { FS_ETPU_TCR1, 0, 0, BAUD_RATE, 2, 0, 16 };
+
+    check(uart_model_init() == 0, "model init");
+    if (flow_control)
+    {
+        inst.rts_chan_num = RTS_CHAN;
+        inst.cts_chan_num = CTS_CHAN;
+    }
+    cfg.bit_count = bit_count;
+    cfg.parity_select = parity_select;
+    cfg.rx_fifo_word_size = rx_fifo_word_size;
+    g_inst = inst;
+    g_cfg = cfg;
+    uart_model_wire(TX_CHAN, RX_CHAN);
+    if (flow_control)
+        uart_model_wire(RTS_CHAN, CTS_CHAN);
+}
+
+static void start(void)
+{
+    check(etpu_uart_init(&g_inst, &g_cfg) == 0, "UART init");
+}
+
+/* start time of the start bit of the k-th word sent from the TX init HSR at time 0, with a full TX FIFO:
+   the first TX check is one stop time out, each word is followed by a stop time */
+static int64_t word_start(
+    int32_t word_index)
+{
+    etpu_if_UART_CHANNEL_FRAME *p_frame = (etpu_if_UART_CHANNEL_FRAME*)g_inst.cpba;
+    int64_t bit_time = p_frame->_bit_time, stop_time = p_frame->_stop_time;
+    int64_t word_bits = 1 + g_cfg.bit_count + (g_cfg.parity_select < ETPU_UART_PARITY_NONE);
+
+    return 2 * stop_time + word_index * (word_bits * bit_time + stop_time);
+}
+
+static void fill_tx_data(
+    uint32_t mask)
+{
+    int32_t i;
+
+    for (i = 0; i < BUFFER_SIZE; i++)
+        g_tx_data[i] = (uint32_t)(i * 37 + 5) & mask;
+}
+
+/* host interrupt handler: drain the RX FIFO, refill the TX FIFO */
+static void rx_drain(void)
+{
+    union uart_rx_data_t data[BUFFER_SIZE];
+    int32_t i, cnt;
+
+    cnt = etpu_uart_receive_data(&g_inst, &g_cfg, data, BUFFER_SIZE, 0);
+    for (i = 0; i < cnt; i++)
+    {
+        if ((data[i].rx_data_word >> 24) != 0)
+            g_rx_errors++;
+        if ((data[i].rx_data_word & 0xffffff) != g_tx_data[g_rx_index % BUFFER_SIZE])
+            g_rx_errors++;
+        g_rx_index++;
+    }
+}
+
+static void tx_fill(void)
+{
+    int32_t cnt = g_tx_total - g_tx_index;
+
+    if (cnt > BUFFER_SIZE - g_tx_index % BUFFER_SIZE)
+        cnt = BUFFER_SIZE - g_tx_index % BUFFER_SIZE;
+    g_tx_index += etpu_uart_transmit_data(&g_inst, &g_cfg, &g_tx_data[g_tx_index % BUFFER_SIZE], cnt);
+}
+
+static void uart_isr(
+    uint8_t chan_num)
+{
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, chan_num);
+    if (chan_num == RX_CHAN)
+        rx_drain();
+    else
+        tx_fill();
+}
+
+/* send word_cnt words through the looped back UART, serviced by interrupt */
+static void run_stream(
+    int32_t word_cnt)
+{
+    int64_t word_time;
+
+    uart_model.isr = uart_isr;
+    g_tx_index = g_rx_index = 0;
+    g_tx_total = word_cnt;
+    g_rx_errors = 0;
+    start();
+    tx_fill();
+    word_time = word_start(1) - word_start(0);
+    while (g_tx_index < g_tx_total && uart_model.p_error == 0)
+        uart_model_run(uart_model.time + word_time);
+    /* let the last words through, then drain below the RX threshold */
+    uart_model_run(uart_model.time + word_time * (g_cfg.tx_fifo_word_size + 2));
+    rx_drain();
+}
+
+static void test_basic_mode(void)
+{
+    uint32_t overrun;
+
+    setup(ETPU_UART_PARITY_NONE, 8, 16, 0);
+    g_cfg.rx_fifo_interrupt_threshold = 12;
+    g_cfg.tx_fifo_interrupt_threshold = 4;
+    fill_tx_data(0xff);
+    run_stream(1000);
+    check(uart_model.p_error == 0, "basic mode, model error");
+    check(g_rx_index == 1000, "basic mode, words lost");
+    check(g_rx_errors == 0, "basic mode, RX data or error flags wrong");
+    etpu_uart_receive_data(&g_inst, &g_cfg, g_rx_data, 1, &overrun);
+    check(overrun == 0, "basic mode, overrun");
+    check(uart_model.int_cnt[RX_CHAN] > 0 && uart_model.int_cnt[TX_CHAN] > 0, "basic mode, no interrupts");
+}
+
+static void test_parity(void)
+{
+    int32_t i;
+
+    setup(ETPU_UART_PARITY_ODD, 16, 16, 0);
+    fill_tx_data(0xffff);
+    start();
+    etpu_uart_transmit_data(&g_inst, &g_cfg, g_tx_data, 4);
+    /* invert data bit 0 of the third word */
+    uart_model_line_fault(RX_CHAN, word_start(2) + 100, word_start(2) + 200);
+    uart_model_run(word_start(5));
+    check(etpu_uart_receive_data(&g_inst, &g_cfg, g_rx_data, 4, 0) == 4, "parity, words lost");
+    for (i = 0; i < 4; i++)
+        check((g_rx_data[i].rx_data_word >> 24) == (i == 2 ? ETPU_UART_RX_PARITY_ERROR : 0), "parity, wrong error flags");
+    check((g_rx_data[2].rx_data_word & 0xffffff) == (g_tx_data[2] ^ 1), "parity, faulted data");
+}
+
+static void test_frame_error(void)
+{
+    int64_t stop_start;
+
+    setup(ETPU_UART_PARITY_EVEN, 8, 16, 0);
+    fill_tx_data(0xff);
+    start();
+    etpu_uart_transmit_data(&g_inst, &g_cfg, g_tx_data, 2);
+    /* pull the stop bit of the first word low */
+    stop_start = word_start(0) + 10 * 100;
+    uart_model_line_fault(RX_CHAN, stop_start, stop_start + 100);
+    uart_model_run(word_start(3));
+    check(etpu_uart_receive_data(&g_inst, &g_cfg, g_rx_data, 2, 0) == 2, "frame error, words lost");
+    check(g_rx_data[0].rx_data_word == ((ETPU_UART_RX_FRAMING_ERROR << 24) | g_tx_data[0]), "frame error, first word");
+    check(g_rx_data[1].rx_data_word == g_tx_data[1], "frame error, second word");
+}
+
+static void test_overrun(void)
+{
+    uint32_t overrun;
+    int32_t i;
+
+    setup(ETPU_UART_PARITY_NONE, 8, 8, 0);
+    fill_tx_data(0xff);
+    start();
+    etpu_uart_transmit_data(&g_inst, &g_cfg, g_tx_data, 12);
+    uart_model_run(word_start(14));
+    /* the newest words are dropped once the RX FIFO holds size - 1 words */
+    check(etpu_uart_receive_data(&g_inst, &g_cfg, g_rx_data, 12, &overrun) == 7, "overrun, words kept");
+    for (i = 0; i < 7; i++)
+        check(g_rx_data[i].rx_data_word == g_tx_data[i], "overrun, RX data");
+    check(overrun == 1, "overrun, not reported");
+    etpu_uart_receive_data(&g_inst, &g_cfg, g_rx_data, 1, &overrun);
+    check(overrun == 0, "overrun, not cleared once read");
+}
+
+static void test_flow_control(void)
+{
+    int32_t size, rx_used, tx_used, read_cnt = 0;
+    uint32_t overrun, hsr_cnt;
+
+    setup(ETPU_UART_PARITY_ODD, 8, 20, 1);
+    g_cfg.tx_fifo_word_size = 20;
+    g_cfg.rts_halt_threshold = 18;
+    g_cfg.rts_resume_threshold = 12;
+    fill_tx_data(0xff);
+    start();
+    etpu_uart_transmit_data(&g_inst, &g_cfg, g_tx_data, 19);
+    uart_model_run(word_start(21));
+    /* CTS is sampled at the start of a stop bit, before the previous word is received,
+       so the word after the one reaching the halt threshold goes out too */
+    etpu_uart_receive_fifo_status(&g_inst, &g_cfg, &size, &rx_used);
+    etpu_uart_transmit_fifo_status(&g_inst, &g_cfg, &size, &tx_used);
+    check(rx_used == 19 && tx_used == 0 && uart_model_pin(RTS_CHAN) == 1, "flow control, RTS halt");
+
+    g_tx_data[0] = 0xaa;
+    etpu_uart_transmit_data(&g_inst, &g_cfg, g_tx_data, 1);
+    uart_model_run(uart_model.time + 10000);
+    etpu_uart_receive_fifo_status(&g_inst, &g_cfg, &size, &rx_used);
+    etpu_uart_transmit_fifo_status(&g_inst, &g_cfg, &size, &tx_used);
+    check(rx_used == 19 && tx_used == 1, "flow control, TX not held");
+
+    /* drain one word at a time: one RTS HSR, on the pop crossing the resume threshold */
+    hsr_cnt = uart_model.hsr_cnt[RX_CHAN];
+    while (rx_used > 12)
+    {
+        uart_model_run(uart_model.time + 100);
+        check(uart_model.hsr_cnt[RX_CHAN] == hsr_cnt && uart_model_pin(RTS_CHAN) == 1, "flow control, RTS released early");
+        etpu_uart_receive_data(&g_inst, &g_cfg, &g_rx_data[read_cnt], 1, &overrun);
+        check(overrun == 0, "flow control, overrun");
+        read_cnt++;
+        etpu_uart_receive_fifo_status(&g_inst, &g_cfg, &size, &rx_used);
+    }
+    uart_model_run(uart_model.time + 10000);
+    check(uart_model.hsr_cnt[RX_CHAN] == hsr_cnt + 1, "flow control, one RTS HSR expected");
+    check(uart_model_pin(RTS_CHAN) == 0, "flow control, RTS not asserted");
+    /* with the held word in, the pop down to the resume threshold crosses it again,
+       the pops below it issue no HSR */
+    while (etpu_uart_receive_data(&g_inst, &g_cfg, &g_rx_data[read_cnt], 1, 0) == 1)
+        read_cnt++;
+    uart_model_run(uart_model.time + 100);
+    check(read_cnt == 20 && g_rx_data[19].rx_data_word == 0xaa, "flow control, held word not received");
+    check(uart_model.hsr_cnt[RX_CHAN] == hsr_cnt + 2, "flow control, RTS HSR count");
+    check(uart_model.p_error == 0, "flow control, model error");
+}
+
+/* data RAM taken by etpu_uart_init() */
+static uint32_t start_ram_size(void)
+{
+    uint32_t free_param = (uint32_t)fs_etpu_free_param;
+
+    start();
+    return (uint32_t)fs_etpu_free_param - free_param;
+}
+
+/* packed RX FIFO: data RAM per UART with an 80 character RX FIFO, and characters with their error
+   flags through the packed FIFO and etpu_uart_receive_bytes() */
+static void measure_packed_rx(void)
+{
+    uint8_t data[48], errors[48];
+    uint32_t ram_size, packed_ram_size, overrun;
+    int32_t i, cnt;
+
+    setup(ETPU_UART_PARITY_EVEN, 8, 80, 0);
+    ram_size = start_ram_size();
+    setup(ETPU_UART_PARITY_EVEN, 8, 80, 0);
+    g_cfg.rx_options = ETPU_UART_RX_OPTION_PACKED_FIFO;
+    packed_ram_size = start_ram_size();
+    printf("packed RX: 80 character RX FIFO and 16 word TX FIFO, %u bytes of data RAM per UART, %u packed "
+           "(RX FIFO %u bytes, %u packed)\n", ram_size, packed_ram_size, ram_size - 0x100 - 64,
+           packed_ram_size - 0x100 - 64);
+    check(ram_size - packed_ram_size == 320 - 104, "packed RX, data RAM"); /* allocations round up to 8 bytes */
+
+    fill_tx_data(0xff);
+    check(etpu_uart_transmit_data(&g_inst, &g_cfg, g_tx_data, 16) == 15, "packed RX, TX FIFO");
+    uart_model_line_fault(RX_CHAN, word_start(5) + 100, word_start(5) + 200);
+    uart_model_run(word_start(16));
+    cnt = etpu_uart_receive_bytes(&g_inst, &g_cfg, data, errors, 48, &overrun);
+    check(cnt == 15 && overrun == 0 && uart_model.p_error == 0, "packed RX, characters lost");
+    for (i = 0; i < cnt; i++)
+    {
+        check(data[i] == (i == 5 ? g_tx_data[i] ^ 1 : g_tx_data[i]), "packed RX, data");
+        check(errors[i] == (i == 5 ? ETPU_UART_RX_PARITY_ERROR : 0), "packed RX, error flags");
+    }
+}
+
+/* RX and TX threads per character of a run of one character, checking the data received */
+static void threads_per_char(
+    uint32_t rx_options,
+    uint32_t tx_options,
+    uint32_t baud_rate,
+    uint8_t  parity_select,
+    uint32_t data,
+    double  *p_rx_threads,
+    double  *p_tx_threads)
+{
+    union uart_rx_data_t rx_data[16];
+    uint32_t tx_data[15], rx_threads, tx_threads;
+    int32_t i, cnt;
+
+    setup(parity_select, 8, 16, 0);
+    g_cfg.baud_rate_hz = baud_rate;
+    g_cfg.rx_options = rx_options;
+    g_cfg.tx_options = tx_options;
+    start();
+    for (i = 0; i < 15; i++)
+        tx_data[i] = data;
+    etpu_uart_transmit_data(&g_inst, &g_cfg, tx_data, 15);
+    rx_threads = uart_model.thread_cnt[RX_CHAN];
+    tx_threads = uart_model.thread_cnt[TX_CHAN];
+    /* up to the start of the next word, but the TX check finding the TX FIFO empty */
+    uart_model_run(word_start(15) - 1);
+    rx_threads = uart_model.thread_cnt[RX_CHAN] - rx_threads;
+    tx_threads = uart_model.thread_cnt[TX_CHAN] - tx_threads - 1;
+    cnt = etpu_uart_receive_data(&g_inst, &g_cfg, rx_data, 16, 0);
+    check(cnt == 15 && uart_model.p_error == 0, "threads per character, characters lost");
+    for (i = 0; i < cnt; i++)
+        check(rx_data[i].rx_data_word == data, "threads per character, data");
+    if (p_rx_threads != 0)
+        *p_rx_threads = (double)rx_threads / 15;
+    if (p_tx_threads != 0)
+        *p_tx_threads = (double)tx_threads / 15;
+}
+
+/* edge decode: RX threads per character against the per-bit engine, 8N1 */
+static void measure_edge_decode(void)
+{
+    static const uint32_t data[] = { 0x00, 0xff, 0x55, 0x0f, 0x93 };
+    double bit_threads, edge_threads;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(data) / sizeof(data[0]); i++)
+    {
+        threads_per_char(0, 0, BAUD_RATE, ETPU_UART_PARITY_NONE, data[i], &bit_threads, 0);
+        threads_per_char(ETPU_UART_RX_OPTION_EDGE_DECODE, 0, BAUD_RATE, ETPU_UART_PARITY_NONE, data[i], &edge_threads, 0);
+        printf("edge decode: 0x%02x, %.1f RX threads per character, %.1f per bit\n", data[i], edge_threads, bit_threads);
+        check(bit_threads == 10 && (i > 1 || edge_threads == 3), "edge decode, threads");
+    }
+    /* a bit time with a fractional part, 572 + 250/256 counts */
+    for (i = 0; i < sizeof(data) / sizeof(data[0]); i++)
+        threads_per_char(ETPU_UART_RX_OPTION_EDGE_DECODE, 0, 115200, ETPU_UART_PARITY_NONE, data[i], 0, 0);
+}
+
+/* run-length TX: TX threads per character against one match per bit, 8N1 and 8O1 */
+static void measure_run_length(void)
+{
+    static const uint32_t data[] = { 0x00, 0xff, 0x55, 0x0f, 0x93 };
+    double bit_threads, rl_threads;
+    uint32_t i;
+    uint8_t parity_select;
+
+    for (parity_select = ETPU_UART_PARITY_NONE; ; parity_select = ETPU_UART_PARITY_ODD)
+    {
+        for (i = 0; i < sizeof(data) / sizeof(data[0]); i++)
+        {
+            threads_per_char(0, 0, BAUD_RATE, parity_select, data[i], 0, &bit_threads);
+            threads_per_char(0, ETPU_UART_TX_OPTION_RUN_LENGTH, BAUD_RATE, parity_select, data[i], 0, &rl_threads);
+            printf("run-length TX: 0x%02x %s, %.1f TX threads per character, %.1f per bit\n", data[i],
+                   parity_select == ETPU_UART_PARITY_NONE ? "8N1" : "8O1", rl_threads, bit_threads);
+            check(rl_threads < bit_threads || data[i] == 0x55, "run-length TX, threads");
+        }
+        if (parity_select == ETPU_UART_PARITY_ODD)
+            break;
+    }
+    /* a bit time with a fractional part */
+    for (i = 0; i < sizeof(data) / sizeof(data[0]); i++)
+        threads_per_char(0, ETPU_UART_TX_OPTION_RUN_LENGTH, 115200, ETPU_UART_PARITY_ODD, data[i], 0, 0);
+}
+
+/* send word_cnt words through the looped back UART, serviced by polling every poll_time TCR1 counts;
+   returns the number of receive calls */
+static int32_t run_polled(
+    int32_t word_cnt,
+    int64_t poll_time)
+{
+    int32_t receive_cnt = 0;
+
+    uart_model.isr = 0;
+    g_tx_index = g_rx_index = 0;
+    g_tx_total = word_cnt;
+    g_rx_errors = 0;
+    start();
+    while (g_rx_index < word_cnt && uart_model.p_error == 0)
+    {
+        tx_fill();
+        uart_model_run(uart_model.time + poll_time);
+        rx_drain();
+        receive_cnt++;
+    }
+    return receive_cnt;
+}
+
+/* RTS HSRs per receive call under polling, against one per call before they were raised only when a pop
+   crosses the resume threshold */
+static void measure_rts_polling(void)
+{
+    static const int64_t poll_times[] = { 100, 1000, 3000, 8000, 20000 };
+    int32_t word_cnt = 2000, receive_cnt;
+    uint32_t i, hsr_cnt;
+    uint8_t flow_control;
+
+    for (flow_control = 0; flow_control < 2; flow_control++)
+    {
+        for (i = 0; i < sizeof(poll_times) / sizeof(poll_times[0]); i++)
+        {
+            setup(ETPU_UART_PARITY_NONE, 8, 16, flow_control);
+            g_cfg.rts_halt_threshold = 12;
+            g_cfg.rts_resume_threshold = 4;
+            fill_tx_data(0xff);
+            receive_cnt = run_polled(word_cnt, poll_times[i]);
+            check(g_rx_index == word_cnt && g_rx_errors == 0 && uart_model.p_error == 0, "RTS polling, RX data");
+            hsr_cnt = uart_model.hsr_cnt[RX_CHAN] - 1; /* but the init HSR */
+            printf("RTS polling: %s, poll every %.1f words, %d receive calls, %u RTS HSRs (%.3f per call, was 1)\n",
+                   flow_control ? "RTS/CTS" : "no RTS", poll_times[i] / 1000.0, receive_cnt, hsr_cnt,
+                   (double)hsr_cnt / receive_cnt);
+            /* none while a poll finds no more words than the resume threshold, at most one per call */
+            check(hsr_cnt <= (uint32_t)receive_cnt && (flow_control || hsr_cnt == 0) &&
+                  (poll_times[i] > 4 * 1000 || hsr_cnt == 0), "RTS polling, HSRs");
+        }
+    }
+}
+
+/* host ring stress: the TX side is a remote sender kept busy at line rate, the RX interrupt is served after a
+   random delay of up to g_isr_jitter TCR1 counts and spills the RX FIFO into the host RX ring, if any */
+static struct uart_ring_t g_rx_ring;
+static uint32_t g_ring_buffer[1024];
+static int64_t g_isr_jitter;
+static uint32_t g_random = 1;
+
+static int64_t ring_isr_delay(
+    uint8_t chan_num)
+{
+    if (chan_num != RX_CHAN || g_isr_jitter == 0)
+        return 0;
+    g_random = g_random * 1103515245 + 12345;
+    return (g_random >> 8) % (g_isr_jitter + 1);
+}
+
+static void ring_isr(
+    uint8_t chan_num)
+{
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, chan_num);
+    if (chan_num == TX_CHAN)
+        tx_fill();
+    else if (g_inst.rx_ring != 0)
+        etpu_uart_rx_ring_fill(&g_inst, &g_cfg, 0);
+}
+
+/* the words lost to RX FIFO overrun out of word_cnt, with the application reading every app_time TCR1 counts
+   from the host RX ring, or from the RX FIFO if no ring */
+static int32_t ring_stress(
+    uint8_t use_ring,
+    int32_t word_cnt,
+    int64_t app_time)
+{
+    int32_t cnt;
+
+    setup(ETPU_UART_PARITY_NONE, 8, 16, 0);
+    g_cfg.rx_fifo_interrupt_threshold = 8;
+    g_cfg.tx_fifo_interrupt_threshold = 8;
+    g_rx_ring.p_buffer = g_ring_buffer;
+    g_rx_ring.word_size = sizeof(g_ring_buffer) / sizeof(g_ring_buffer[0]);
+    g_inst.rx_ring = use_ring ? &g_rx_ring : 0;
+    uart_model.isr = ring_isr;
+    uart_model.isr_delay = ring_isr_delay;
+    g_tx_index = g_rx_index = 0;
+    g_tx_total = word_cnt;
+    start();
+    tx_fill();
+    do
+    {
+        uart_model_run(uart_model.time + app_time);
+        do
+        {
+            if (use_ring)
+                cnt = etpu_uart_ring_read(&g_inst, g_rx_data, BUFFER_SIZE);
+            else
+                cnt = etpu_uart_receive_data(&g_inst, &g_cfg, g_rx_data, BUFFER_SIZE, 0);
+            g_rx_index += cnt;
+        } while (cnt == BUFFER_SIZE);
+    } while (cnt > 0 || g_tx_index < g_tx_total);
+    /* the words left below the RX interrupt threshold */
+    if (use_ring)
+    {
+        etpu_uart_rx_ring_fill(&g_inst, &g_cfg, 0);
+        g_rx_index += etpu_uart_ring_read(&g_inst, g_rx_data, BUFFER_SIZE);
+    }
+    check(uart_model.p_error == 0 && g_tx_index == word_cnt, "host ring stress, model error");
+    return word_cnt - g_rx_index;
+}
+
+/* host ring: RX overrun rate against the RX interrupt latency jitter, with a 16-word RX FIFO (interrupt
+   threshold 8) and the application reading every 64 word times, from a 1024-word host ring or from the
+   RX FIFO without ring */
+static void measure_host_ring(void)
+{
+    static const int32_t jitters[] = { 0, 2, 4, 6, 8, 12, 16, 32 };
+    int32_t word_cnt = 20000, lost, ring_lost;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(jitters) / sizeof(jitters[0]); i++)
+    {
+        g_isr_jitter = jitters[i] * 1000;
+        lost = ring_stress(0, word_cnt, 64 * 1000);
+        ring_lost = ring_stress(1, word_cnt, 64 * 1000);
+        printf("host ring: RX interrupt delay up to %2d words, overrun %.2f%% with ring, %.2f%% without\n",
+               jitters[i], 100.0 * ring_lost / word_cnt, 100.0 * lost / word_cnt);
+        check(jitters[i] > 7 || ring_lost == 0, "host ring, overrun within the FIFO headroom");
+    }
+    g_isr_jitter = 0;
+    uart_model.isr_delay = 0;
+}
+
+/* coalescing: the RX interrupt handler drains the RX FIFO, and keeps the worst latency of a word, from the
+   time it was pushed onto the RX FIFO (seen through the push pointer) to the handler */
+static int64_t g_push_time[BUFFER_SIZE];
+static int32_t g_push_cnt, g_isr_cnt;
+static int64_t g_max_latency;
+
+static void track_push(void)
+{
+    etpu_if_UART_CHANNEL_FRAME *p_frame = (etpu_if_UART_CHANNEL_FRAME*)g_inst.cpba;
+    int32_t push_index = (p_frame->_rx_buffer_push_p - p_frame->_rx_buffer_start_p) / 4;
+
+    while (g_push_cnt % (int32_t)g_cfg.rx_fifo_word_size != push_index)
+        g_push_time[g_push_cnt++ % BUFFER_SIZE] = uart_model.time;
+}
+
+static void coalesce_isr(
+    uint8_t chan_num)
+{
+    int32_t i, cnt;
+
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, chan_num);
+    if (chan_num != RX_CHAN)
+        return;
+    track_push();
+    g_isr_cnt++;
+    cnt = etpu_uart_receive_data(&g_inst, &g_cfg, g_rx_data, BUFFER_SIZE, 0);
+    for (i = 0; i < cnt; i++, g_rx_index++)
+    {
+        if (uart_model.time - g_push_time[g_rx_index % BUFFER_SIZE] > g_max_latency)
+            g_max_latency = uart_model.time - g_push_time[g_rx_index % BUFFER_SIZE];
+    }
+}
+
+/* RX interrupts per word and worst word latency in microseconds, for burst_cnt bursts of burst_size words
+   every burst_period TCR1 counts, the words left in the RX FIFO at the end not counted */
+static void coalesce_run(
+    uint32_t threshold,
+    uint32_t latency_us,
+    uint32_t word_count,
+    int32_t  burst_size,
+    int64_t  burst_period,
+    double  *p_int_per_word,
+    double  *p_max_latency_us)
+{
+    int32_t i, burst_cnt = 200, tx_cnt = 0;
+    int64_t end_time;
+
+    setup(ETPU_UART_PARITY_NONE, 8, 32, 0);
+    g_cfg.rx_fifo_interrupt_threshold = threshold;
+    g_cfg.rx_coalesce_latency_us = latency_us;
+    g_cfg.rx_coalesce_word_count = word_count;
+    uart_model.isr = coalesce_isr;
+    fill_tx_data(0xff);
+    g_rx_index = g_push_cnt = g_isr_cnt = 0;
+    g_max_latency = 0;
+    start();
+    for (i = 0; i < burst_cnt; i++)
+    {
+        tx_cnt += etpu_uart_transmit_data(&g_inst, &g_cfg, g_tx_data, burst_size);
+        /* the push times to a bit time */
+        for (end_time = uart_model.time + burst_period; uart_model.time < end_time; )
+        {
+            uart_model_run(uart_model.time + 100);
+            track_push();
+        }
+    }
+    uart_model_run(uart_model.time + 2000);
+    track_push();
+    check(uart_model.p_error == 0 && g_push_cnt == tx_cnt, "coalescing, words lost");
+    *p_int_per_word = (double)g_isr_cnt / g_rx_index;
+    *p_max_latency_us = g_max_latency * 1e6 / etpu_a_tcr1_freq;
+}
+
+/* coalescing: RX interrupts per word and worst latency against the RX FIFO threshold interrupt, for a
+   continuous stream and for sparse bursts of 5 words */
+static void measure_coalescing(void)
+{
+    static const struct
+    {
+        const char *p_name;
+        uint32_t    threshold, latency_us, word_count;
+    } modes[] =
+    {
+        { "threshold 1", 1, 0, 0 },
+        { "threshold 8", 8, 0, 0 },
+        { "coalesce 8 words/100 us", 0, 100, 8 },
+        { "coalesce 16 words/100 us", 0, 100, 16 },
+        { "coalesce 8 words/50 us", 0, 50, 8 },
+    };
+    double int_per_word[2], max_latency_us[2];
+    uint32_t i;
+
+    for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        coalesce_run(modes[i].threshold, modes[i].latency_us, modes[i].word_count, 15, 15 * 1000,
+                     &int_per_word[0], &max_latency_us[0]);
+        coalesce_run(modes[i].threshold, modes[i].latency_us, modes[i].word_count, 5, 40 * 1000,
+                     &int_per_word[1], &max_latency_us[1]);
+        printf("coalescing: %-24s continuous %.3f interrupts per word, latency up to %.1f us; "
+               "bursts of 5 %.3f, up to %.1f us\n", modes[i].p_name, int_per_word[0], max_latency_us[0],
+               int_per_word[1], max_latency_us[1]);
+        /* the latency timeout is timed while the line is idle, but only checked as words are received
+           otherwise: up to one word time late */
+        if (modes[i].latency_us != 0)
+            check(max_latency_us[0] <= modes[i].latency_us + 1e6 * 1000 / etpu_a_tcr1_freq &&
+                  max_latency_us[1] <= modes[i].latency_us + 1e6 * 1000 / etpu_a_tcr1_freq, "coalescing, latency cap");
+    }
+}
+
+/* idle park: TX threads per second of idle TX channels, 1 Mbaud 8N1, polling or parked, as many TX-only UARTs
+   with 2-word TX FIFOs as fit in the data RAM, up to 16 */
+static void measure_idle_park(void)
+{
+    static struct uart_instance_t inst[16];
+    static struct uart_config_t cfg[16];
+    uint32_t park, k, uart_cnt, thread_cnt[2], hsr_cnt;
+    int32_t size, used;
+    int64_t idle_time = etpu_a_tcr1_freq / 100; /* 10 ms */
+
+    for (park = 0; park < 2; park++)
+    {
+        check(uart_model_init() == 0, "idle park, model init");
+        for (uart_cnt = 0; uart_cnt < 16; uart_cnt++)
+        {
+            struct uart_instance_t uart_inst = { EM_AB, 0xff, (uint8_t)uart_cnt, 0xff, 0xff, 0xff, FS_ETPU_PRIORITY_MIDDLE };
+            struct uart_config_t uart_cfg = { FS_ETPU_TCR1, 8, ETPU_UART_PARITY_NONE, 1000000, 2, 0, 2 };
+
+            uart_cfg.tx_options = park ? ETPU_UART_TX_OPTION_IDLE_PARK : 0;
+            inst[uart_cnt] = uart_inst;
+            cfg[uart_cnt] = uart_cfg;
+            if (etpu_uart_init(&inst[uart_cnt], &cfg[uart_cnt]) != 0)
+                break;
+        }
+        /* past the init threads and the first TX checks */
+        uart_model_run(1000);
+        thread_cnt[park] = 0;
+        for (k = 0; k < uart_cnt; k++)
+            thread_cnt[park] -= uart_model.thread_cnt[k];
+        uart_model_run(uart_model.time + idle_time);
+        for (k = 0; k < uart_cnt; k++)
+            thread_cnt[park] += uart_model.thread_cnt[k];
+        printf("idle park: %u idle TX channels at 1 Mbaud, %s, %.0f TX threads per second\n", uart_cnt,
+               park ? "parked" : "polling", thread_cnt[park] * 100.0);
+        check(uart_model.p_error == 0 && uart_cnt > 0, "idle park, UARTs");
+    }
+    check(thread_cnt[1] == 0, "idle park, parked channels run threads");
+
+    /* a push onto the empty TX FIFO of a parked channel wakes it with one HSR, and it parks again once sent */
+    hsr_cnt = uart_model.hsr_cnt[0];
+    g_tx_data[0] = 0x5a;
+    check(etpu_uart_transmit_data(&inst[0], &cfg[0], g_tx_data, 1) == 1, "idle park, transmit");
+    uart_model_run(uart_model.time + 2000);
+    etpu_uart_transmit_fifo_status(&inst[0], &cfg[0], &size, &used);
+    check(uart_model.hsr_cnt[0] == hsr_cnt + 1 && used == 0 && ((etpu_if_UART_CHANNEL_FRAME*)inst[0].cpba)->_tx_parked == 1,
+          "idle park, wake");
+}
+
+/* line throughput and host interrupt load for a long interrupt-driven stream,
+   and the model speed */
+static void benchmark(void)
+{
+    int32_t word_cnt = 50000;
+    uint32_t hsr_cnt;
+    clock_t start_clock;
+    double cpu_time;
+
+    setup(ETPU_UART_PARITY_NONE, 8, 64, 1);
+    g_cfg.tx_fifo_word_size = 64;
+    g_cfg.rx_fifo_interrupt_threshold = 48;
+    g_cfg.tx_fifo_interrupt_threshold = 16;
+    g_cfg.rts_halt_threshold = 56;
+    g_cfg.rts_resume_threshold = 40;
+    fill_tx_data(0xff);
+    start_clock = clock();
+    run_stream(word_cnt);
+    cpu_time = (double)(clock() - start_clock) / CLOCKS_PER_SEC;
+    check(g_rx_index == word_cnt && g_rx_errors == 0 && uart_model.p_error == 0, "benchmark, RX data");
+    hsr_cnt = uart_model.hsr_cnt[RX_CHAN] - 1; /* but the init HSR */
+    printf("benchmark: %d words, line busy %.1f%%, per 100 words %.2f RX and %.2f TX interrupts, %.2f RTS HSRs, "
+           "%.1f RX and %.1f TX threads\n",
+           word_cnt, 100.0 * word_cnt * 10 * 100 / (double)uart_model.time,
+           100.0 * uart_model.int_cnt[RX_CHAN] / word_cnt, 100.0 * uart_model.int_cnt[TX_CHAN] / word_cnt,
+           100.0 * hsr_cnt / word_cnt, 100.0 * uart_model.thread_cnt[RX_CHAN] / word_cnt,
+           100.0 * uart_model.thread_cnt[TX_CHAN] / word_cnt);
+    if (cpu_time > 0)
+        printf("benchmark: %.0f modeled words per second\n", word_cnt / cpu_time);
+}
+
+int main(void)
+{
+    test_basic_mode();
+    test_parity();
+    test_frame_error();
+    test_overrun();
+    test_flow_control();
+    benchmark();
+    measure_packed_rx();
+    measure_edge_decode();
+    measure_run_length();
+    measure_rts_polling();
+    measure_host_ring();
+    measure_coalescing();
+    measure_idle_park();
+    printf("%s\n", g_fail_cnt == 0 ? "PASS" : "FAIL");
+    return g_fail_cnt != 0;
+}